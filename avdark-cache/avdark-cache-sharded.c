@@ -0,0 +1,311 @@
+/**
+ * Concurrent, sharded, shared cache model for replaying traces from
+ * multiple producers. See avdark-cache-sharded.h for an overview.
+ *
+ * Course: Advanced Computer Architecture, Uppsala University
+ * Course Part: Lab assignment 1
+ */
+
+#include "avdark-cache-sharded.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+
+#define RING_MASK (AVDC_SHARDED_RING_SIZE - 1)
+
+/**
+ * Producers publish their progress at least this often (in issued
+ * accesses) so that shards waiting for them can keep going.
+ */
+#define PROGRESS_INTERVAL 64
+
+static int
+is_power_of_two(uint64_t val)
+{
+        return ((((val)&(val-1)) == 0) && (val > 0));
+}
+
+static inline avdc_sharded_ring_t *
+ring_of(avdc_sharded_t *self, int producer, int shard)
+{
+        return &self->rings[producer * self->no_shards + shard];
+}
+
+static inline int
+shard_from_pa(avdc_sharded_t *self, avdc_pa_t pa)
+{
+        return (pa >> self->shard_shift) & self->shard_mask;
+}
+
+/**
+ * Worker thread main loop. Repeatedly picks the input ring with the
+ * lowest pending sequence number and simulates accesses from it for
+ * as long as no other producer can have an access with a lower
+ * sequence number pending.
+ */
+static void *
+shard_main(void *arg)
+{
+        avdc_sharded_shard_t *shard = arg;
+        avdc_sharded_t *self = shard->owner;
+
+        for (;;) {
+                avdc_sharded_ring_t *best = NULL;
+                uint64_t best_seq = UINT64_MAX;
+                /* No access with a sequence number >= limit may be
+                 * simulated before we have rescanned all rings */
+                uint64_t limit = UINT64_MAX;
+                int done = 1;
+
+                for (int p = 0; p < self->no_producers; p++) {
+                        avdc_sharded_ring_t *ring = ring_of(self, p, shard->id);
+                        /* Load progress before checking the ring, all
+                         * accesses below progress are visible once we
+                         * have seen it. */
+                        uint64_t progress =
+                                atomic_load_explicit(&self->producers[p].progress,
+                                                     memory_order_acquire);
+                        uint64_t head = atomic_load_explicit(&ring->head,
+                                                             memory_order_relaxed);
+                        uint64_t tail = atomic_load_explicit(&ring->tail,
+                                                             memory_order_acquire);
+
+                        if (head != tail) {
+                                uint64_t seq = ring->entries[head & RING_MASK].seq;
+                                done = 0;
+                                if (seq < best_seq) {
+                                        if (best_seq < limit)
+                                                limit = best_seq;
+                                        best = ring;
+                                        best_seq = seq;
+                                } else if (seq < limit) {
+                                        limit = seq;
+                                }
+                        } else {
+                                if (progress != UINT64_MAX)
+                                        done = 0;
+                                if (progress < limit)
+                                        limit = progress;
+                        }
+                }
+
+                if (best && best_seq < limit) {
+                        uint64_t head = atomic_load_explicit(&best->head,
+                                                             memory_order_relaxed);
+                        uint64_t tail = atomic_load_explicit(&best->tail,
+                                                             memory_order_acquire);
+
+                        while (head != tail) {
+                                const avdc_sharded_entry_t *e =
+                                        &best->entries[head & RING_MASK];
+                                if (e->seq >= limit)
+                                        break;
+                                avdc_access_cos(shard->cache, e->pa, e->type, e->cos);
+                                head++;
+                        }
+                        atomic_store_explicit(&best->head, head,
+                                              memory_order_release);
+                } else if (done) {
+                        break;
+                } else {
+                        sched_yield();
+                }
+        }
+
+        return NULL;
+}
+
+void
+avdc_sharded_access(avdc_sharded_t *self, int producer, uint64_t seq,
+                    avdc_pa_t pa, avdc_access_type_t type)
+{
+        avdc_sharded_producer_t *prod = &self->producers[producer];
+        avdc_sharded_ring_t *ring = ring_of(self, producer, shard_from_pa(self, pa));
+        uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        avdc_sharded_entry_t *e;
+
+        if (++prod->issued % PROGRESS_INTERVAL == 0)
+                atomic_store_explicit(&prod->progress, seq, memory_order_release);
+
+        if (tail - atomic_load_explicit(&ring->head, memory_order_acquire) ==
+            AVDC_SHARDED_RING_SIZE) {
+                /* The shard may be waiting for us in order to drain
+                 * this ring, tell it how far we have come. */
+                atomic_store_explicit(&prod->progress, seq, memory_order_release);
+                while (tail - atomic_load_explicit(&ring->head, memory_order_acquire) ==
+                       AVDC_SHARDED_RING_SIZE)
+                        sched_yield();
+        }
+
+        e = &ring->entries[tail & RING_MASK];
+        e->seq = seq;
+        e->pa = pa;
+        e->type = type;
+        e->cos = prod->cos;
+        atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+}
+
+void
+avdc_sharded_set_producer_cos(avdc_sharded_t *self, int producer, avdc_cos_t cos)
+{
+        self->producers[producer].cos = cos;
+}
+
+int
+avdc_sharded_set_cos_mask(avdc_sharded_t *self, avdc_cos_t cos, avdc_way_mask_t mask)
+{
+        for (int s = 0; s < self->no_shards; s++) {
+                if (!avdc_set_cos_mask(self->shards[s].cache, cos, mask))
+                        return 0;
+        }
+
+        return 1;
+}
+
+int
+avdc_sharded_add_cos_range(avdc_sharded_t *self, avdc_pa_t start, avdc_pa_t end,
+                           avdc_cos_t cos)
+{
+        for (int s = 0; s < self->no_shards; s++) {
+                if (!avdc_add_cos_range(self->shards[s].cache, start, end, cos))
+                        return 0;
+        }
+
+        return 1;
+}
+
+int
+avdc_sharded_enable_ucp(avdc_sharded_t *self, unsigned no_cos, uint64_t interval)
+{
+        for (int s = 0; s < self->no_shards; s++) {
+                if (!avdc_enable_ucp(self->shards[s].cache, no_cos, interval))
+                        return 0;
+        }
+
+        return 1;
+}
+
+void
+avdc_sharded_producer_done(avdc_sharded_t *self, int producer)
+{
+        atomic_store_explicit(&self->producers[producer].progress, UINT64_MAX,
+                              memory_order_release);
+}
+
+void
+avdc_sharded_finish(avdc_sharded_t *self)
+{
+        self->stat_data_write = 0;
+        self->stat_data_write_miss = 0;
+        self->stat_data_read = 0;
+        self->stat_data_read_miss = 0;
+        memset(self->stat_cos_access, 0, sizeof(self->stat_cos_access));
+        memset(self->stat_cos_miss, 0, sizeof(self->stat_cos_miss));
+
+        for (int s = 0; s < self->no_shards; s++) {
+                avdark_cache_t *cache = self->shards[s].cache;
+
+                pthread_join(self->shards[s].thread, NULL);
+
+                self->stat_data_write += cache->stat_data_write;
+                self->stat_data_write_miss += cache->stat_data_write_miss;
+                self->stat_data_read += cache->stat_data_read;
+                self->stat_data_read_miss += cache->stat_data_read_miss;
+                for (int c = 0; c < AVDC_MAX_COS; c++) {
+                        self->stat_cos_access[c] += cache->stat_cos_access[c];
+                        self->stat_cos_miss[c] += cache->stat_cos_miss[c];
+                }
+        }
+}
+
+avdc_sharded_t *
+avdc_sharded_new(avdc_size_t size, avdc_block_size_t block_size,
+                 avdc_assoc_t assoc, int no_shards, int no_producers)
+{
+        avdc_sharded_t *self;
+        int s, p;
+
+        if (!is_power_of_two(no_shards) || no_producers <= 0) {
+                fprintf(stderr, "no_shards has to be a power of two and no_producers > zero\n");
+                return NULL;
+        }
+
+        if (!is_power_of_two(size) || size / no_shards < block_size * assoc) {
+                fprintf(stderr, "every shard needs at least one set\n");
+                return NULL;
+        }
+
+        self = calloc(1, sizeof(*self));
+        self->no_shards = no_shards;
+        self->no_producers = no_producers;
+        self->shard_mask = no_shards - 1;
+
+        self->shards = aligned_alloc(AVDC_SHARDED_CACHE_LINE,
+                                     no_shards * sizeof(*self->shards));
+        self->producers = aligned_alloc(AVDC_SHARDED_CACHE_LINE,
+                                        no_producers * sizeof(*self->producers));
+        self->rings = aligned_alloc(AVDC_SHARDED_CACHE_LINE,
+                                    no_producers * no_shards * sizeof(*self->rings));
+
+        for (p = 0; p < no_producers; p++) {
+                atomic_init(&self->producers[p].progress, 0);
+                self->producers[p].issued = 0;
+                self->producers[p].cos = AVDC_COS_FROM_PA;
+                for (s = 0; s < no_shards; s++) {
+                        atomic_init(&ring_of(self, p, s)->head, 0);
+                        atomic_init(&ring_of(self, p, s)->tail, 0);
+                }
+        }
+
+        /* Every shard is a cache with the same block size and
+         * associativity but a fraction of the sets. The shard is
+         * selected by the most significant index bits, so the index
+         * within the shard is what the smaller cache computes on its
+         * own, and the shard bits end up at the bottom of its tag. */
+        for (s = 0; s < no_shards; s++) {
+                avdc_sharded_shard_t *shard = &self->shards[s];
+
+                shard->cache = avdc_new(size / no_shards, block_size, assoc);
+                shard->owner = self;
+                shard->id = s;
+                if (!shard->cache) {
+                        fprintf(stderr, "Failed to initialize shard %d\n", s);
+                        abort();
+                }
+        }
+        self->shard_shift = self->shards[0].cache->tag_shift;
+
+        for (s = 0; s < no_shards; s++) {
+                if (pthread_create(&self->shards[s].thread, NULL,
+                                   shard_main, &self->shards[s]) != 0) {
+                        perror("pthread_create");
+                        abort();
+                }
+        }
+
+        return self;
+}
+
+void
+avdc_sharded_delete(avdc_sharded_t *self)
+{
+        for (int s = 0; s < self->no_shards; s++)
+                avdc_delete(self->shards[s].cache);
+
+        free(self->shards);
+        free(self->producers);
+        free(self->rings);
+        free(self);
+}
+
+/*
+ * Local Variables:
+ * mode: c
+ * c-basic-offset: 8
+ * indent-tabs-mode: nil
+ * c-file-style: "linux"
+ * compile-command: "make -k -C ../../"
+ * End:
+ */
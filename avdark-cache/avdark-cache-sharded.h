@@ -0,0 +1,210 @@
+/**
+ * Concurrent, sharded, shared cache model for replaying traces from
+ * multiple producers.
+ *
+ * The sets of the simulated cache are split into shards using the
+ * most significant index bits. Every shard is an ordinary AvDark cache
+ * instance that is owned exclusively by one worker thread, so the
+ * shards need no locking. Producers hand accesses to the shards
+ * through one single-producer/single-consumer ring per producer and
+ * shard.
+ *
+ * Every access carries a sequence number that defines its position
+ * in the global interleaving of all producers. Each shard merges its
+ * input rings in sequence number order, so the results are identical
+ * to calling avdc_access() on a single cache with the accesses
+ * sorted by sequence number.
+ *
+ * Course: Advanced Computer Architecture, Uppsala University
+ * Course Part: Lab assignment 1
+ */
+
+#ifndef AVDARK_CACHE_SHARDED_H
+#define AVDARK_CACHE_SHARDED_H
+
+#include "avdark-cache.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+/** Number of entries in every producer to shard ring, power of two */
+#define AVDC_SHARDED_RING_SIZE 4096
+
+#define AVDC_SHARDED_CACHE_LINE 64
+
+/**
+ * A single access in flight from a producer to a shard.
+ */
+typedef struct {
+        uint64_t           seq;
+        avdc_pa_t          pa;
+        avdc_access_type_t type;
+        avdc_cos_t         cos;
+} avdc_sharded_entry_t;
+
+/**
+ * Single-producer/single-consumer ring. The head is only written by
+ * the consumer and the tail only by the producer, they live in
+ * separate cache lines to avoid false sharing.
+ */
+typedef struct {
+        _Alignas(AVDC_SHARDED_CACHE_LINE) _Atomic uint64_t head;
+        _Alignas(AVDC_SHARDED_CACHE_LINE) _Atomic uint64_t tail;
+        _Alignas(AVDC_SHARDED_CACHE_LINE)
+        avdc_sharded_entry_t entries[AVDC_SHARDED_RING_SIZE];
+} avdc_sharded_ring_t;
+
+/**
+ * Per-producer state.
+ */
+typedef struct {
+        /**
+         * Lower bound on the sequence numbers of all accesses that
+         * the producer has not yet issued. UINT64_MAX once the
+         * producer is done. Lets the shards make progress when a
+         * producer has nothing in their ring.
+         */
+        _Alignas(AVDC_SHARDED_CACHE_LINE) _Atomic uint64_t progress;
+        /** Accesses issued so far, private to the producer */
+        _Alignas(AVDC_SHARDED_CACHE_LINE) uint64_t issued;
+        /** Class of service of the producer's accesses */
+        avdc_cos_t         cos;
+} avdc_sharded_producer_t;
+
+/**
+ * Per-shard state, only touched by the shard's worker thread once
+ * the simulation has started.
+ */
+typedef struct {
+        _Alignas(AVDC_SHARDED_CACHE_LINE) avdark_cache_t *cache;
+        pthread_t          thread;
+        /** Back pointer used by the worker thread */
+        struct avdc_sharded *owner;
+        int                id;
+} avdc_sharded_shard_t;
+
+/**
+ * Sharded cache simulator instance.
+ */
+typedef struct avdc_sharded {
+        int                     no_shards;
+        int                     no_producers;
+        /** Shift and mask used to extract the shard from an address */
+        int                     shard_shift;
+        avdc_pa_t               shard_mask;
+
+        avdc_sharded_shard_t    *shards;
+        avdc_sharded_producer_t *producers;
+        /** Ring for producer p and shard s at rings[p * no_shards + s] */
+        avdc_sharded_ring_t     *rings;
+
+        /**
+         * Aggregated statistics, valid after avdc_sharded_finish().
+         *
+         * @{
+         */
+        uint64_t                stat_data_write;
+        uint64_t                stat_data_write_miss;
+        uint64_t                stat_data_read;
+        uint64_t                stat_data_read_miss;
+        uint64_t                stat_cos_access[AVDC_MAX_COS];
+        uint64_t                stat_cos_miss[AVDC_MAX_COS];
+        /** @} */
+} avdc_sharded_t;
+
+/**
+ * Create a new sharded cache simulator and start its worker threads.
+ *
+ * @param size Cache size in bytes
+ * @param block_size Cache block size in bytes
+ * @param assoc Cache associativiy
+ * @param no_shards Number of shards (worker threads), must be a power
+ * of two that does not exceed the number of sets
+ * @param no_producers Number of threads that will issue accesses
+ * @return NULL on error
+ */
+avdc_sharded_t *avdc_sharded_new(avdc_size_t size, avdc_block_size_t block_size,
+                                 avdc_assoc_t assoc,
+                                 int no_shards, int no_producers);
+
+/**
+ * Destroy a sharded cache simulator. avdc_sharded_finish() must have
+ * been called first.
+ *
+ * @param self Simulator instance
+ */
+void avdc_sharded_delete(avdc_sharded_t *self);
+
+/**
+ * Cache partitioning. These functions apply the corresponding
+ * avdark-cache function to every shard, see avdc_set_cos_mask(),
+ * avdc_add_cos_range() and avdc_enable_ucp(). They must be called
+ * before any accesses are issued. Note that with UCP every shard
+ * monitors and partitions its own sets independently, the results
+ * will therefore differ from an unsharded cache.
+ *
+ * @{
+ */
+int avdc_sharded_set_cos_mask(avdc_sharded_t *self, avdc_cos_t cos,
+                              avdc_way_mask_t mask);
+int avdc_sharded_add_cos_range(avdc_sharded_t *self, avdc_pa_t start,
+                               avdc_pa_t end, avdc_cos_t cos);
+int avdc_sharded_enable_ucp(avdc_sharded_t *self, unsigned no_cos,
+                            uint64_t interval);
+/** @} */
+
+/**
+ * Set the class of service of all accesses issued by a producer,
+ * which models per-thread classes. Defaults to AVDC_COS_FROM_PA. Must
+ * be called by the producer itself or before it starts issuing
+ * accesses.
+ *
+ * @param self Simulator instance
+ * @param producer Producer id
+ * @param cos Class of service
+ */
+void avdc_sharded_set_producer_cos(avdc_sharded_t *self, int producer,
+                                   avdc_cos_t cos);
+
+/**
+ * Issue a cache access. May only be called by the thread acting as
+ * the given producer, and every producer must issue its accesses in
+ * increasing sequence number order. Sequence numbers must be unique
+ * across producers.
+ *
+ * @param self Simulator instance
+ * @param producer Producer id, 0 <= producer < no_producers
+ * @param seq Position of the access in the global interleaving
+ * @param pa Physical address to access
+ * @param type Access type
+ */
+void avdc_sharded_access(avdc_sharded_t *self, int producer, uint64_t seq,
+                         avdc_pa_t pa, avdc_access_type_t type);
+
+/**
+ * Signal that a producer will not issue any more accesses.
+ *
+ * @param self Simulator instance
+ * @param producer Producer id
+ */
+void avdc_sharded_producer_done(avdc_sharded_t *self, int producer);
+
+/**
+ * Wait for all producers to finish and all shards to drain, then
+ * collect the statistics.
+ *
+ * @param self Simulator instance
+ */
+void avdc_sharded_finish(avdc_sharded_t *self);
+
+#endif
+
+/*
+ * Local Variables:
+ * mode: c
+ * c-basic-offset: 8
+ * indent-tabs-mode: nil
+ * c-file-style: "linux"
+ * compile-command: "make -k -C ../../"
+ * End:
+ */
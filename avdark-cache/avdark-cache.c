@@ -19,6 +19,11 @@
 #include <assert.h>
 #include <inttypes.h>
 
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
 #ifdef SIMICS
 /* Simics stuff  */
 #include <simics/api.h>
@@ -46,6 +51,78 @@ struct avdc_cache_line {
         int age; //for LRU replacement policy
 };
 
+/**
+ * Address range to class of service mapping, see
+ * avdc_add_cos_range().
+ */
+struct avdc_cos_range {
+        avdc_pa_t  start;
+        avdc_pa_t  end;
+        avdc_cos_t cos;
+};
+
+/**
+ * Utility-based partitioning state. Every class of service has a
+ * shadow tag directory (ATD) for a sample of the sets. The ATD is
+ * managed using true LRU and counts hits per LRU stack position,
+ * which tells how many hits the class would get with any number of
+ * ways.
+ */
+struct avdc_ucp {
+        unsigned    no_cos;
+        uint64_t    interval;
+        /** Accesses since the last re-partitioning */
+        uint64_t    accesses;
+        /** Sets with index % sample_interval == 0 are monitored */
+        int         sample_interval;
+        int         no_sampled_sets;
+        /**
+         * Shadow tags, most recently used first, for class c and
+         * sampled set s at atd[(c * no_sampled_sets + s) * assoc].
+         * Tags are stored plus one, 0 marks an invalid entry.
+         */
+        avdc_tag_t *atd;
+        /** Hits for class c at LRU stack position p at hits[c * assoc + p] */
+        uint64_t   *hits;
+        /** Current number of ways allocated to each class */
+        unsigned    alloc[AVDC_MAX_COS];
+};
+
+/** Number of sets sampled by the UCP monitors */
+#define AVDC_UCP_SAMPLED_SETS 32
+
+/**
+ * Snapshot file header, see avdc_save(). The header is immediately
+ * followed by the array of cache lines and, if UCP is enabled, by the
+ * UCP shadow tags and hit counters.
+ */
+typedef struct {
+        char     magic[8];
+        uint32_t version;
+        /** sizeof(avdc_cache_line_t), guards against layout changes */
+        uint32_t line_struct_size;
+        uint32_t size;
+        uint32_t block_size;
+        uint32_t assoc;
+        uint32_t number_of_lines;
+        uint64_t stat_data_write;
+        uint64_t stat_data_write_miss;
+        uint64_t stat_data_read;
+        uint64_t stat_data_read_miss;
+        uint64_t stat_cos_access[AVDC_MAX_COS];
+        uint64_t stat_cos_miss[AVDC_MAX_COS];
+        uint64_t cos_mask[AVDC_MAX_COS];
+        /** UCP state, ucp_no_cos is 0 if UCP is disabled */
+        uint64_t ucp_interval;
+        uint64_t ucp_accesses;
+        uint32_t ucp_no_cos;
+        uint32_t ucp_no_sampled_sets;
+        uint32_t ucp_alloc[AVDC_MAX_COS];
+} avdc_snapshot_header_t;
+
+#define AVDC_SNAPSHOT_MAGIC "AVDCSNAP"
+#define AVDC_SNAPSHOT_VERSION 2
+
 /**
  * Extract the cache line tag from a physical address.
  *
@@ -100,6 +177,237 @@ is_power_of_two(uint64_t val)
         return ((((val)&(val-1)) == 0) && (val > 0));
 }
 
+/**
+ * Mask with one bit set for every way in a cache with the given
+ * associativity.
+ */
+static avdc_way_mask_t
+full_way_mask(avdc_assoc_t assoc)
+{
+        return assoc >= 64 ? ~(avdc_way_mask_t)0 : ((avdc_way_mask_t)1 << assoc) - 1;
+}
+
+/**
+ * Check if a way may be allocated under a mask. Ways beyond what the
+ * mask can represent may only be allocated under a full mask.
+ */
+static inline int
+way_in_mask(avdc_way_mask_t mask, avdc_assoc_t way)
+{
+        return way < 64 ? (mask >> way) & 1 : mask == ~(avdc_way_mask_t)0;
+}
+
+/**
+ * Contiguous mask of count ways starting at way first.
+ */
+static avdc_way_mask_t
+contiguous_way_mask(unsigned first, unsigned count)
+{
+        return full_way_mask(count) << first;
+}
+
+static inline avdc_cos_t
+cos_from_pa(avdark_cache_t *self, avdc_pa_t pa)
+{
+        for (int i = 0; i < self->no_cos_ranges; i++) {
+                if (pa >= self->cos_ranges[i].start && pa < self->cos_ranges[i].end)
+                        return self->cos_ranges[i].cos;
+        }
+
+        return 0;
+}
+
+/**
+ * Update the shadow tags of a class of service for an access to a
+ * sampled set.
+ */
+static void
+ucp_access(avdark_cache_t *self, int index, avdc_tag_t tag, avdc_cos_t cos)
+{
+        avdc_ucp_t *ucp = self->ucp;
+        avdc_tag_t *stack;
+        avdc_assoc_t pos;
+
+        if (cos >= ucp->no_cos || index % ucp->sample_interval)
+                return;
+
+        stack = &ucp->atd[(cos * ucp->no_sampled_sets + index / ucp->sample_interval) *
+                          self->assoc];
+        for (pos = 0; pos < self->assoc - 1; pos++) {
+                if (stack[pos] == tag + 1)
+                        break;
+        }
+        if (stack[pos] == tag + 1)
+                ucp->hits[cos * self->assoc + pos] += 1;
+
+        /* Move to the MRU position, dropping the LRU entry on a miss */
+        memmove(&stack[1], &stack[0], pos * sizeof(*stack));
+        stack[0] = tag + 1;
+}
+
+/**
+ * Re-partition the ways between the classes using the lookahead
+ * algorithm.
+ */
+static void
+ucp_repartition(avdark_cache_t *self)
+{
+        avdc_ucp_t *ucp = self->ucp;
+        unsigned balance = self->assoc - ucp->no_cos;
+        unsigned first;
+        avdc_cos_t c;
+
+        for (c = 0; c < ucp->no_cos; c++)
+                ucp->alloc[c] = 1;
+
+        while (balance) {
+                avdc_cos_t winner = 0;
+                unsigned winner_ways = 0;
+                double winner_mu = -1;
+
+                for (c = 0; c < ucp->no_cos; c++) {
+                        const uint64_t *hits = &ucp->hits[c * self->assoc];
+                        uint64_t sum = 0;
+
+                        /* Find the maximum marginal utility (extra
+                         * hits per extra way) of this class */
+                        for (unsigned k = 1; k <= balance; k++) {
+                                double mu;
+
+                                sum += hits[ucp->alloc[c] + k - 1];
+                                mu = (double)sum / k;
+                                if (mu > winner_mu) {
+                                        winner = c;
+                                        winner_ways = k;
+                                        winner_mu = mu;
+                                }
+                        }
+                }
+
+                ucp->alloc[winner] += winner_ways;
+                balance -= winner_ways;
+        }
+
+        for (c = 0, first = 0; c < ucp->no_cos; first += ucp->alloc[c], c++)
+                self->cos_mask[c] = contiguous_way_mask(first, ucp->alloc[c]);
+
+        /* Age the monitors so that the partitioning adapts to phase
+         * changes */
+        for (unsigned i = 0; i < ucp->no_cos * self->assoc; i++)
+                ucp->hits[i] /= 2;
+
+        avdc_dbg_log(self, "ucp: re-partitioned, ways of cos 0: %u\n", ucp->alloc[0]);
+}
+
+static inline void
+ucp_tick(avdark_cache_t *self)
+{
+        if (++self->ucp->accesses >= self->ucp->interval) {
+                self->ucp->accesses = 0;
+                ucp_repartition(self);
+        }
+}
+
+static void
+ucp_delete(avdark_cache_t *self)
+{
+        if (self->ucp) {
+                AVDC_FREE(self->ucp->atd);
+                AVDC_FREE(self->ucp->hits);
+                AVDC_FREE(self->ucp);
+                self->ucp = NULL;
+        }
+}
+
+int
+avdc_enable_ucp(avdark_cache_t *self, unsigned no_cos, uint64_t interval)
+{
+        avdc_ucp_t *ucp;
+        size_t atd_entries;
+
+        if (no_cos < 1 || no_cos > AVDC_MAX_COS || no_cos > self->assoc ||
+            self->assoc > 64 || interval == 0) {
+                fprintf(stderr, "UCP needs 1 <= no_cos <= min(%d, assoc), assoc <= 64 "
+                        "and interval > 0\n", AVDC_MAX_COS);
+                return 0;
+        }
+
+        ucp_delete(self);
+
+        ucp = AVDC_MALLOC(1, avdc_ucp_t);
+        memset(ucp, 0, sizeof(*ucp));
+        ucp->no_cos = no_cos;
+        ucp->interval = interval;
+        ucp->sample_interval = self->number_of_sets > AVDC_UCP_SAMPLED_SETS ?
+                self->number_of_sets / AVDC_UCP_SAMPLED_SETS : 1;
+        ucp->no_sampled_sets = self->number_of_sets / ucp->sample_interval;
+
+        atd_entries = (size_t)no_cos * ucp->no_sampled_sets * self->assoc;
+        ucp->atd = AVDC_MALLOC(atd_entries, avdc_tag_t);
+        memset(ucp->atd, 0, atd_entries * sizeof(avdc_tag_t));
+        ucp->hits = AVDC_MALLOC(no_cos * self->assoc, uint64_t);
+        memset(ucp->hits, 0, no_cos * self->assoc * sizeof(uint64_t));
+
+        self->ucp = ucp;
+
+        /* Start out with an even split */
+        for (avdc_cos_t c = 0, first = 0; c < no_cos; c++) {
+                unsigned ways = self->assoc / no_cos + (c < self->assoc % no_cos);
+
+                ucp->alloc[c] = ways;
+                self->cos_mask[c] = contiguous_way_mask(first, ways);
+                first += ways;
+        }
+
+        return 1;
+}
+
+int
+avdc_set_cos_mask(avdark_cache_t *self, avdc_cos_t cos, avdc_way_mask_t mask)
+{
+        avdc_way_mask_t shifted = mask;
+
+        while (shifted && !(shifted & 1))
+                shifted >>= 1;
+
+        if (cos >= AVDC_MAX_COS || !mask ||
+            (mask & ~full_way_mask(self->assoc)) ||
+            (shifted & (shifted + 1))) {
+                fprintf(stderr, "CoS masks have to be non-empty and contiguous ways\n");
+                return 0;
+        }
+
+        ucp_delete(self);
+        self->cos_mask[cos] = mask;
+
+        return 1;
+}
+
+int
+avdc_add_cos_range(avdark_cache_t *self, avdc_pa_t start, avdc_pa_t end,
+                   avdc_cos_t cos)
+{
+        avdc_cos_range_t *ranges;
+
+        if (cos >= AVDC_MAX_COS || start >= end) {
+                fprintf(stderr, "Invalid CoS address range\n");
+                return 0;
+        }
+
+        ranges = realloc(self->cos_ranges,
+                         (self->no_cos_ranges + 1) * sizeof(avdc_cos_range_t));
+        if (!ranges)
+                return 0;
+
+        ranges[self->no_cos_ranges].start = start;
+        ranges[self->no_cos_ranges].end = end;
+        ranges[self->no_cos_ranges].cos = cos;
+        self->cos_ranges = ranges;
+        self->no_cos_ranges++;
+
+        return 1;
+}
+
 void
 avdc_dbg_log(avdark_cache_t *self, const char *msg, ...)
 {
@@ -116,13 +424,29 @@ avdc_dbg_log(avdark_cache_t *self, const char *msg, ...)
 
 
 
-void avdc_access(avdark_cache_t *self, avdc_pa_t pa, avdc_access_type_t type) {
+void
+avdc_access(avdark_cache_t *self, avdc_pa_t pa, avdc_access_type_t type)
+{
+        avdc_access_cos(self, pa, type, AVDC_COS_FROM_PA);
+}
+
+void
+avdc_access_cos(avdark_cache_t *self, avdc_pa_t pa, avdc_access_type_t type,
+                avdc_cos_t cos)
+{
     avdc_tag_t tag = tag_from_pa(self, pa);
     int index = index_from_pa(self, pa);
     int hit = 0;
 
-    // Search for hit
-    for (int i = 0; i < self->assoc; i++) {
+    if (cos == AVDC_COS_FROM_PA)
+        cos = cos_from_pa(self, pa);
+    assert(cos < AVDC_MAX_COS);
+
+    if (self->ucp)
+        ucp_access(self, index, tag, cos);
+
+    // Search for hit, any way may hit regardless of the partitioning
+    for (avdc_assoc_t i = 0; i < self->assoc; i++) {
         if (self->lines[index * self->assoc + i].valid == 1 && self->lines[index * self->assoc + i].tag == tag) {
             hit = 1;
             self->lines[index * self->assoc + i].age = 0; // Reset age of hit line
@@ -131,15 +455,20 @@ void avdc_access(avdark_cache_t *self, avdc_pa_t pa, avdc_access_type_t type) {
     }
 
     if (!hit) {
-        // If miss, find the least recently used line to replace
-        int lru_index = 0;
+        // If miss, find the least recently used line among the ways
+        // this class of service may allocate into
+        const avdc_way_mask_t mask = self->cos_mask[cos];
+        avdc_assoc_t lru_index = self->assoc; // None found yet
         int max_age = 0;
-        for (int i = 0; i < self->assoc; i++) {
-            if (self->lines[index * self->assoc + i].age > max_age) {//find the line with the highest age
+        for (avdc_assoc_t i = 0; i < self->assoc; i++) {
+            if (!way_in_mask(mask, i))
+                continue;
+            if (lru_index == self->assoc || self->lines[index * self->assoc + i].age > max_age) {//find the line with the highest age
                 max_age = self->lines[index * self->assoc + i].age; //update max age
                 lru_index = i;//the least recently used line is the one with the highest age
             }
         }
+        assert(lru_index < self->assoc);
 
         // Replace the least recently used line
         self->lines[index * self->assoc + lru_index].valid = 1;
@@ -147,41 +476,54 @@ void avdc_access(avdark_cache_t *self, avdc_pa_t pa, avdc_access_type_t type) {
         self->lines[index * self->assoc + lru_index].age = 0;
 
         // Increment age of other lines in the set
-        for (int i = 0; i < self->assoc; i++) {
+        for (avdc_assoc_t i = 0; i < self->assoc; i++) {
             if (i != lru_index)
                 self->lines[index * self->assoc + i].age++;
         }
         }
+
+        self->stat_cos_access[cos] += 1;
+        if (!hit)
+                self->stat_cos_miss[cos] += 1;
+
         switch (type) {
         case AVDC_READ: /* Read accesses */
-                avdc_dbg_log(self, "read: pa: 0x%.16lx, tag: 0x%.16lx, index: %d, hit: %d\n",
-                             (unsigned long)pa, (unsigned long)tag, index, hit);
+                avdc_dbg_log(self, "read: pa: 0x%.16lx, tag: 0x%.16lx, index: %d, cos: %u, hit: %d\n",
+                             (unsigned long)pa, (unsigned long)tag, index, cos, hit);
                 self->stat_data_read += 1;
                 if (!hit)
                         self->stat_data_read_miss += 1;
                 break;
 
         case AVDC_WRITE: /* Write accesses */
-                avdc_dbg_log(self, "write: pa: 0x%.16lx, tag: 0x%.16lx, index: %d, hit: %d\n",
-                             (unsigned long)pa, (unsigned long)tag, index, hit);
+                avdc_dbg_log(self, "write: pa: 0x%.16lx, tag: 0x%.16lx, index: %d, cos: %u, hit: %d\n",
+                             (unsigned long)pa, (unsigned long)tag, index, cos, hit);
                 self->stat_data_write += 1;
                 if (!hit)
                         self->stat_data_write_miss += 1;
                 break;
         }
+
+        if (self->ucp)
+                ucp_tick(self);
 }
 
 void
 avdc_flush_cache(avdark_cache_t *self){
         /* HINT: You will need to update this function */
         for (int i = 0; i < self->number_of_sets; i++) { //set all lines to invalid for all ways
-                for (int j = 0; j < self->assoc; j++){      
+                for (avdc_assoc_t j = 0; j < self->assoc; j++){      
                 self->lines[i * self->assoc + j ].valid = 0;
                 self->lines[i * self->assoc + j].tag = 0;
                 self->lines[i * self->assoc + j].age = 0;
                 
                 }
         }
+
+        if (self->ucp)
+                memset(self->ucp->atd, 0,
+                       (size_t)self->ucp->no_cos * self->ucp->no_sampled_sets *
+                       self->assoc * sizeof(avdc_tag_t));
 }
 
 int
@@ -201,6 +543,12 @@ avdc_resize(avdark_cache_t *self,avdc_size_t size, avdc_block_size_t block_size,
                 return 0;
         }
 
+        /* Reset the partitioning if the ways changed */
+        if (assoc != self->assoc) {
+                for (int i = 0; i < AVDC_MAX_COS; i++)
+                        self->cos_mask[i] = full_way_mask(assoc);
+        }
+
         /* Update the stored parameters */
         self->size = size;
         self->block_size = block_size;
@@ -222,9 +570,211 @@ avdc_resize(avdark_cache_t *self,avdc_size_t size, avdc_block_size_t block_size,
         /* Flush the cache, this initializes the tag array to a known state */
         avdc_flush_cache(self);
 
+        /* The UCP monitors depend on the geometry, start over */
+        if (self->ucp &&
+            !avdc_enable_ucp(self, self->ucp->no_cos, self->ucp->interval))
+                ucp_delete(self);
+
+        return 1;
+}
+
+/**
+ * Number of UCP shadow tag entries and hit counters for the given
+ * geometry.
+ */
+static size_t
+ucp_atd_entries(unsigned no_cos, unsigned no_sampled_sets, avdc_assoc_t assoc)
+{
+        return (size_t)no_cos * no_sampled_sets * assoc;
+}
+
+static size_t
+ucp_hits_entries(unsigned no_cos, avdc_assoc_t assoc)
+{
+        return (size_t)no_cos * assoc;
+}
+
+/**
+ * Write len bytes to fd, retrying on short writes.
+ */
+static int
+write_all(int fd, const void *buf, size_t len)
+{
+        const char *p = buf;
+
+        while (len) {
+                ssize_t ret = write(fd, p, len);
+                if (ret < 0) {
+                        perror("write");
+                        return 0;
+                }
+                p += ret;
+                len -= ret;
+        }
+
         return 1;
 }
 
+int
+avdc_save(avdark_cache_t *self, const char *path)
+{
+        const avdc_ucp_t *ucp = self->ucp;
+        avdc_snapshot_header_t hdr;
+        int fd;
+        int ok;
+
+        memset(&hdr, 0, sizeof(hdr));
+        memcpy(hdr.magic, AVDC_SNAPSHOT_MAGIC, sizeof(hdr.magic));
+        hdr.version = AVDC_SNAPSHOT_VERSION;
+        hdr.line_struct_size = sizeof(avdc_cache_line_t);
+        hdr.size = self->size;
+        hdr.block_size = self->block_size;
+        hdr.assoc = self->assoc;
+        hdr.number_of_lines = self->number_of_sets * self->assoc;
+        hdr.stat_data_write = self->stat_data_write;
+        hdr.stat_data_write_miss = self->stat_data_write_miss;
+        hdr.stat_data_read = self->stat_data_read;
+        hdr.stat_data_read_miss = self->stat_data_read_miss;
+        memcpy(hdr.stat_cos_access, self->stat_cos_access, sizeof(hdr.stat_cos_access));
+        memcpy(hdr.stat_cos_miss, self->stat_cos_miss, sizeof(hdr.stat_cos_miss));
+        memcpy(hdr.cos_mask, self->cos_mask, sizeof(hdr.cos_mask));
+        if (ucp) {
+                hdr.ucp_interval = ucp->interval;
+                hdr.ucp_accesses = ucp->accesses;
+                hdr.ucp_no_cos = ucp->no_cos;
+                hdr.ucp_no_sampled_sets = ucp->no_sampled_sets;
+                memcpy(hdr.ucp_alloc, ucp->alloc, sizeof(hdr.ucp_alloc));
+        }
+
+        fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+                perror(path);
+                return 0;
+        }
+
+        ok = write_all(fd, &hdr, sizeof(hdr)) &&
+                write_all(fd, self->lines,
+                          hdr.number_of_lines * sizeof(avdc_cache_line_t));
+        if (ok && ucp) {
+                ok = write_all(fd, ucp->atd,
+                               ucp_atd_entries(ucp->no_cos, ucp->no_sampled_sets,
+                                               self->assoc) * sizeof(avdc_tag_t)) &&
+                        write_all(fd, ucp->hits,
+                                  ucp_hits_entries(ucp->no_cos, self->assoc) *
+                                  sizeof(uint64_t));
+        }
+
+        if (close(fd) != 0) {
+                perror(path);
+                ok = 0;
+        }
+
+        avdc_dbg_log(self, "saved snapshot to %s\n", path);
+
+        return ok;
+}
+
+int
+avdc_restore(avdark_cache_t *self, const char *path)
+{
+        const avdc_snapshot_header_t *hdr;
+        struct stat st;
+        void *map;
+        const char *data;
+        size_t lines_size, atd_size, hits_size;
+        int fd;
+        int ok = 0;
+
+        fd = open(path, O_RDONLY);
+        if (fd < 0) {
+                perror(path);
+                return 0;
+        }
+
+        if (fstat(fd, &st) != 0) {
+                perror(path);
+                close(fd);
+                return 0;
+        }
+
+        if (st.st_size < (off_t)sizeof(*hdr)) {
+                fprintf(stderr, "%s: snapshot too small\n", path);
+                close(fd);
+                return 0;
+        }
+
+        map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED) {
+                perror("mmap");
+                return 0;
+        }
+
+        hdr = map;
+        if (memcmp(hdr->magic, AVDC_SNAPSHOT_MAGIC, sizeof(hdr->magic)) ||
+            hdr->version != AVDC_SNAPSHOT_VERSION ||
+            hdr->line_struct_size != sizeof(avdc_cache_line_t) ||
+            hdr->ucp_no_cos > AVDC_MAX_COS) {
+                fprintf(stderr, "%s: not a compatible cache snapshot\n", path);
+                goto out;
+        }
+
+        lines_size = (size_t)hdr->number_of_lines * sizeof(avdc_cache_line_t);
+        atd_size = ucp_atd_entries(hdr->ucp_no_cos, hdr->ucp_no_sampled_sets,
+                                   hdr->assoc) * sizeof(avdc_tag_t);
+        hits_size = ucp_hits_entries(hdr->ucp_no_cos, hdr->assoc) * sizeof(uint64_t);
+        if ((size_t)st.st_size != sizeof(*hdr) + lines_size + atd_size + hits_size) {
+                fprintf(stderr, "%s: truncated snapshot\n", path);
+                goto out;
+        }
+
+        if (!avdc_resize(self, hdr->size, hdr->block_size, hdr->assoc))
+                goto out;
+
+        if (hdr->number_of_lines != (uint32_t)(self->number_of_sets * self->assoc)) {
+                fprintf(stderr, "%s: inconsistent snapshot\n", path);
+                goto out;
+        }
+
+        /* Enable (or disable) UCP first, enabling it resets the masks */
+        if (hdr->ucp_no_cos) {
+                if (!avdc_enable_ucp(self, hdr->ucp_no_cos, hdr->ucp_interval))
+                        goto out;
+                if ((uint32_t)self->ucp->no_sampled_sets != hdr->ucp_no_sampled_sets) {
+                        fprintf(stderr, "%s: inconsistent snapshot\n", path);
+                        goto out;
+                }
+        } else {
+                ucp_delete(self);
+        }
+
+        data = (const char *)(hdr + 1);
+        memcpy(self->lines, data, lines_size);
+        data += lines_size;
+        if (self->ucp) {
+                memcpy(self->ucp->atd, data, atd_size);
+                data += atd_size;
+                memcpy(self->ucp->hits, data, hits_size);
+                self->ucp->accesses = hdr->ucp_accesses;
+                memcpy(self->ucp->alloc, hdr->ucp_alloc, sizeof(self->ucp->alloc));
+        }
+        memcpy(self->cos_mask, hdr->cos_mask, sizeof(self->cos_mask));
+
+        self->stat_data_write = hdr->stat_data_write;
+        self->stat_data_write_miss = hdr->stat_data_write_miss;
+        self->stat_data_read = hdr->stat_data_read;
+        self->stat_data_read_miss = hdr->stat_data_read_miss;
+        memcpy(self->stat_cos_access, hdr->stat_cos_access, sizeof(self->stat_cos_access));
+        memcpy(self->stat_cos_miss, hdr->stat_cos_miss, sizeof(self->stat_cos_miss));
+
+        avdc_dbg_log(self, "restored snapshot from %s\n", path);
+        ok = 1;
+
+out:
+        munmap(map, st.st_size);
+        return ok;
+}
+
 void
 avdc_print_info(avdark_cache_t *self)
 {
@@ -255,6 +805,8 @@ avdc_reset_statistics(avdark_cache_t *self)
         self->stat_data_read_miss = 0;
         self->stat_data_write = 0;
         self->stat_data_write_miss = 0;
+        memset(self->stat_cos_access, 0, sizeof(self->stat_cos_access));
+        memset(self->stat_cos_miss, 0, sizeof(self->stat_cos_miss));
 }
 
 avdark_cache_t *
@@ -282,6 +834,8 @@ avdc_delete(avdark_cache_t *self)
         if (self->lines){
                 AVDC_FREE(self->lines);
         }
+        ucp_delete(self);
+        free(self->cos_ranges);
         AVDC_FREE(self);
 }
 
@@ -22,6 +22,20 @@ typedef unsigned avdc_block_size_t;
 typedef unsigned avdc_assoc_t;
 typedef avdc_pa_t avdc_tag_t;
 
+/** Class of service (CoS) used for cache partitioning */
+typedef unsigned avdc_cos_t;
+/** Bit mask of the ways a class of service may allocate into */
+typedef uint64_t avdc_way_mask_t;
+
+/** Number of supported classes of service */
+#define AVDC_MAX_COS 16
+
+/**
+ * Pseudo class of service that tells avdc_access_cos() to look up the
+ * class in the address range table, see avdc_add_cos_range().
+ */
+#define AVDC_COS_FROM_PA ((avdc_cos_t)-1)
+
 /**
  * Memory access type to simulate.
  */
@@ -37,6 +51,13 @@ typedef enum {
  */
 typedef struct avdc_cache_line avdc_cache_line_t;
 
+/**
+ * Forward declarations of the partitioning state, declared in
+ * avdark-cache.c.
+ */
+typedef struct avdc_cos_range avdc_cos_range_t;
+typedef struct avdc_ucp avdc_ucp_t;
+
 /**
  * Cache simulator instance variables
  */
@@ -94,6 +115,32 @@ typedef struct {
         uint64_t           stat_data_read;
         uint64_t           stat_data_read_miss;
         /** @} */
+
+        /**
+         * Cache partitioning. Every access belongs to a class of
+         * service (CoS), which may hit in any way but only allocate
+         * into the ways in its mask. All classes may use all ways
+         * by default. Use avdc_set_cos_mask(), avdc_add_cos_range()
+         * and avdc_enable_ucp() to change the partitioning.
+         *
+         * @{
+         */
+        avdc_way_mask_t    cos_mask[AVDC_MAX_COS];
+        avdc_cos_range_t  *cos_ranges;
+        int                no_cos_ranges;
+        /** Utility-based partitioning state, NULL unless enabled */
+        avdc_ucp_t        *ucp;
+        /** @} */
+
+        /**
+         * Per class of service statistics, reset together with the
+         * other statistics.
+         *
+         * @{
+         */
+        uint64_t           stat_cos_access[AVDC_MAX_COS];
+        uint64_t           stat_cos_miss[AVDC_MAX_COS];
+        /** @} */
 } avdark_cache_t;
 
 /**
@@ -157,6 +204,62 @@ void avdc_flush_cache(avdark_cache_t *self);
  */
 void avdc_access(avdark_cache_t *self, avdc_pa_t pa, avdc_access_type_t type);
 
+/**
+ * Execute a cache line access on behalf of a class of service. The
+ * access may hit in any way, but a miss only allocates into the ways
+ * in the class's mask. avdc_access() is equivalent to calling this
+ * function with AVDC_COS_FROM_PA.
+ *
+ * @param self Simulator instance
+ * @param pa Physical address to access
+ * @param type Access type
+ * @param cos Class of service, or AVDC_COS_FROM_PA to use the class
+ * of the address range pa belongs to (0 if none)
+ */
+void avdc_access_cos(avdark_cache_t *self, avdc_pa_t pa,
+                     avdc_access_type_t type, avdc_cos_t cos);
+
+/**
+ * Restrict the ways a class of service may allocate into. Just like
+ * Intel CAT, the mask must be a non-empty, contiguous set of
+ * ways. Disables utility-based partitioning.
+ *
+ * @param self Simulator instance
+ * @param cos Class of service
+ * @param mask Way mask, bit i set means that way i may be allocated
+ * @return 0 on error, 1 on success
+ */
+int avdc_set_cos_mask(avdark_cache_t *self, avdc_cos_t cos, avdc_way_mask_t mask);
+
+/**
+ * Assign the addresses [start, end) to a class of service. Used for
+ * accesses with the class AVDC_COS_FROM_PA. Ranges are searched in
+ * the order they were added.
+ *
+ * @param self Simulator instance
+ * @param start First address in the range
+ * @param end First address after the range
+ * @param cos Class of service
+ * @return 0 on error, 1 on success
+ */
+int avdc_add_cos_range(avdark_cache_t *self, avdc_pa_t start, avdc_pa_t end,
+                       avdc_cos_t cos);
+
+/**
+ * Enable utility-based cache partitioning (UCP). Shadow tag monitors
+ * sample the hit rate each class would get with any number of ways,
+ * and every interval accesses the ways are re-partitioned between
+ * classes 0 to no_cos - 1 using the lookahead algorithm (Qureshi and
+ * Patt, MICRO 2006). Every class gets at least one way.
+ *
+ * @param self Simulator instance
+ * @param no_cos Number of classes to partition between, at most
+ * min(AVDC_MAX_COS, assoc)
+ * @param interval Number of accesses between re-partitioning
+ * @return 0 on error, 1 on success
+ */
+int avdc_enable_ucp(avdark_cache_t *self, unsigned no_cos, uint64_t interval);
+
 /**
  * Reset cache statistics
  *
@@ -164,6 +267,32 @@ void avdc_access(avdark_cache_t *self, avdc_pa_t pa, avdc_access_type_t type);
  */
 void avdc_reset_statistics(avdark_cache_t *self);
 
+/**
+ * Save the complete simulator state (cache parameters, tags,
+ * replacement state, way masks, UCP state and statistics) to a binary
+ * snapshot file. The snapshot can later be loaded with avdc_restore()
+ * to start a simulation with a warm cache. The address ranges of the
+ * classes of service are configuration and are not saved.
+ *
+ * @param self Simulator instance
+ * @param path Snapshot file to create
+ * @return 0 on error, 1 on success
+ */
+int avdc_save(avdark_cache_t *self, const char *path);
+
+/**
+ * Restore the simulator state from a snapshot created by
+ * avdc_save(). The cache is resized to the parameters stored in the
+ * snapshot. The snapshot is mapped into memory rather than read, so
+ * restoring large caches is cheap.
+ *
+ * @param self Simulator instance
+ * @param path Snapshot file to load
+ * @return 0 on error, 1 on success. The simulator state is undefined
+ * if the snapshot was valid but could not be loaded.
+ */
+int avdc_restore(avdark_cache_t *self, const char *path);
+
 /**
  * Print information about the cache, e.g. size and other parameters.
  *
@@ -31,7 +31,63 @@ KNOB<UINT32> knob_associativity(KNOB_MODE_WRITEONCE, "pintool",
 KNOB<UINT32> knob_line_size(KNOB_MODE_WRITEONCE, "pintool",
 			    "l", "64", "Cache line size");
 
+KNOB<BOOL> knob_icache(KNOB_MODE_WRITEONCE, "pintool",
+                       "icache", "0", "Simulate a separate instruction cache");
+KNOB<UINT32> knob_icache_size(KNOB_MODE_WRITEONCE, "pintool",
+                              "is", "32768", "Instruction cache size (bytes)");
+KNOB<UINT32> knob_icache_associativity(KNOB_MODE_WRITEONCE, "pintool",
+                                       "ia", "8", "Instruction cache associativity");
+KNOB<UINT32> knob_icache_line_size(KNOB_MODE_WRITEONCE, "pintool",
+                                   "il", "64", "Instruction cache line size");
+
+KNOB<UINT64> knob_skip(KNOB_MODE_WRITEONCE, "pintool",
+                       "skip", "0", "Instructions to fast-forward before simulating");
+KNOB<UINT64> knob_length(KNOB_MODE_WRITEONCE, "pintool",
+                         "length", "0", "Instructions to simulate in total, over all "
+                         "ROI entries, 0 means no limit");
+KNOB<BOOL> knob_roi(KNOB_MODE_WRITEONCE, "pintool",
+                    "roi", "0", "Only simulate between the ROI marker functions");
+KNOB<std::string> knob_roi_begin(KNOB_MODE_WRITEONCE, "pintool",
+                                 "roi_begin", "util_roi_begin",
+                                 "Function marking the start of the ROI");
+KNOB<std::string> knob_roi_end(KNOB_MODE_WRITEONCE, "pintool",
+                               "roi_end", "util_roi_end",
+                               "Function marking the end of the ROI");
+
+KNOB<std::string> knob_restore(KNOB_MODE_WRITEONCE, "pintool",
+                               "restore", "", "Start from a cache snapshot "
+                               "(overrides -s, -a and -l)");
+KNOB<std::string> knob_save(KNOB_MODE_WRITEONCE, "pintool",
+                            "save", "", "Save a cache snapshot on exit");
+
 static avdark_cache_t *avdc = NULL;
+static avdark_cache_t *avdc_icache = NULL;
+
+/**
+ * Simulation phases. The simulator starts out fast-forwarding if a
+ * region of interest has been specified (-skip or -roi) and stops
+ * simulating for good once -length instructions have been simulated.
+ */
+typedef enum {
+        PHASE_FAST_FORWARD = 0,
+        PHASE_SIMULATE,
+        PHASE_DONE,
+} phase_t;
+
+static phase_t phase = PHASE_SIMULATE;
+
+/** Instructions left in the current phase when counting is enabled */
+static UINT64 icount_left = 0;
+
+/**
+ * Instructions left of the -length budget, 0 if there is no limit.
+ * Saved here while fast-forwarding between two ROI entries.
+ */
+static UINT64 simulate_left = 0;
+
+/** Entry points of the ROI marker functions, 0 if not found */
+static ADDRINT roi_begin_addr = 0;
+static ADDRINT roi_end_addr = 0;
 
 /**
  * Memory access callback. Will be called for every memory access
@@ -47,6 +103,82 @@ simulate_access(VOID *addr, UINT32 access_type)
 
 }
 
+/**
+ * Switch to a new simulation phase. All instrumentation is removed
+ * from the code cache so that code is re-instrumented according to
+ * the new phase, code outside the ROI therefore runs without any
+ * simulation callbacks at all. Execution is restarted at ctxt since
+ * the currently executing trace still carries the old
+ * instrumentation.
+ */
+static VOID
+switch_phase(phase_t new_phase, const CONTEXT *ctxt)
+{
+        /* The budget never runs down to 0 while simulating, the phase
+         * ends before that, so 0 still means no limit */
+        if (phase == PHASE_SIMULATE)
+                simulate_left = icount_left;
+        phase = new_phase;
+        icount_left = phase == PHASE_SIMULATE ? simulate_left : 0;
+
+        PIN_RemoveInstrumentation();
+        PIN_ExecuteAt(ctxt);
+}
+
+/**
+ * Instruction counting callback. Called once for every basic block
+ * while counting instructions towards the end of the current
+ * phase. Returns non-zero when the phase should end, in which case
+ * PIN calls count_expired(). Simple enough to be inlined by PIN.
+ */
+static ADDRINT
+count_instructions(UINT32 no_ins)
+{
+        if (icount_left <= no_ins) {
+                icount_left = 0;
+                return 1;
+        }
+
+        icount_left -= no_ins;
+        return 0;
+}
+
+static VOID
+count_expired(CONTEXT *ctxt)
+{
+        switch_phase(phase == PHASE_FAST_FORWARD ? PHASE_SIMULATE : PHASE_DONE,
+                     ctxt);
+}
+
+/**
+ * ROI marker callback, called when the application enters one of
+ * the marker functions.
+ */
+static VOID
+roi_marker(UINT32 begin, CONTEXT *ctxt)
+{
+        if (begin && phase == PHASE_FAST_FORWARD)
+                switch_phase(PHASE_SIMULATE, ctxt);
+        else if (!begin && phase == PHASE_SIMULATE)
+                switch_phase(PHASE_FAST_FORWARD, ctxt);
+}
+
+/**
+ * Instruction fetch callback. Called once for every basic block
+ * executed by the target application. The block covers no_lines
+ * consecutive cache lines starting at the line address first_line,
+ * each of which is fetched once.
+ */
+static VOID
+simulate_fetch(ADDRINT first_line, UINT32 no_lines)
+{
+        const ADDRINT line_size = avdc_icache->block_size;
+
+        for (UINT32 i = 0; i < no_lines; i++)
+                avdc_access(avdc_icache, (avdc_pa_t)(first_line + i * line_size),
+                            AVDC_READ);
+}
+
 /**
  * PIN instrumentation callback, called for every new instruction that
  * PIN discovers in the application. This function is used to
@@ -56,6 +188,9 @@ simulate_access(VOID *addr, UINT32 access_type)
 static VOID
 instruction(INS ins, VOID *not_used)
 {
+        if (phase != PHASE_SIMULATE)
+                return;
+
         UINT32 no_ops = INS_MemoryOperandCount(ins);
 
         for (UINT32 op = 0; op < no_ops; op++) {
@@ -72,6 +207,81 @@ instruction(INS ins, VOID *not_used)
         }
 }
 
+/**
+ * Instrument a basic block with a single call that fetches all cache
+ * lines the block covers.
+ */
+static VOID
+icache_bbl(BBL bbl)
+{
+        const ADDRINT line_mask = ~((ADDRINT)avdc_icache->block_size - 1);
+        const ADDRINT start = BBL_Address(bbl);
+        const ADDRINT first_line = start & line_mask;
+        const ADDRINT last_line = (start + BBL_Size(bbl) - 1) & line_mask;
+        const UINT32 no_lines =
+                (last_line - first_line) / avdc_icache->block_size + 1;
+
+        BBL_InsertCall(bbl, IPOINT_BEFORE,
+                       (AFUNPTR)simulate_fetch,
+                       IARG_ADDRINT, first_line,
+                       IARG_UINT32, no_lines,
+                       IARG_END);
+}
+
+/**
+ * PIN instrumentation callback, called for every new trace that PIN
+ * discovers in the application. Instruments the ROI markers and,
+ * depending on the phase, the instruction counter and the
+ * instruction cache. Instrumenting the instruction cache per basic
+ * block rather than per instruction keeps its overhead down.
+ */
+static VOID
+trace(TRACE trace, VOID *not_used)
+{
+        for (BBL bbl = TRACE_BblHead(trace); BBL_Valid(bbl); bbl = BBL_Next(bbl)) {
+                const ADDRINT start = BBL_Address(bbl);
+
+                if (phase == PHASE_DONE)
+                        break;
+
+                if (start && (start == roi_begin_addr || start == roi_end_addr))
+                        INS_InsertCall(BBL_InsHead(bbl), IPOINT_BEFORE,
+                                       (AFUNPTR)roi_marker,
+                                       IARG_UINT32, start == roi_begin_addr,
+                                       IARG_CONTEXT,
+                                       IARG_END);
+
+                if (icount_left) {
+                        BBL_InsertIfCall(bbl, IPOINT_BEFORE,
+                                         (AFUNPTR)count_instructions,
+                                         IARG_UINT32, BBL_NumIns(bbl),
+                                         IARG_END);
+                        BBL_InsertThenCall(bbl, IPOINT_BEFORE,
+                                           (AFUNPTR)count_expired,
+                                           IARG_CONTEXT,
+                                           IARG_END);
+                }
+
+                if (phase == PHASE_SIMULATE && avdc_icache)
+                        icache_bbl(bbl);
+        }
+}
+
+/**
+ * PIN image load callback. Used to find the ROI marker functions.
+ */
+static VOID
+image_load(IMG img, VOID *not_used)
+{
+        RTN rtn = RTN_FindByName(img, knob_roi_begin.Value().c_str());
+        if (RTN_Valid(rtn))
+                roi_begin_addr = RTN_Address(rtn);
+
+        rtn = RTN_FindByName(img, knob_roi_end.Value().c_str());
+        if (RTN_Valid(rtn))
+                roi_end_addr = RTN_Address(rtn);
+}
+
 /**
  * PIN fini callback. Called after the target application has
  * terminated. Used to print statistics and do cleanup.
@@ -92,6 +302,22 @@ fini(INT32 code, VOID *v)
         out << "  Misses: " << misses << std::endl;
         out << "  Miss Ratio: " << ((100.0 * misses) / accesses) << "%" << std::endl;
 
+        if (!knob_save.Value().empty() &&
+            !avdc_save(avdc, knob_save.Value().c_str()))
+                std::cerr << "Failed to save cache snapshot." << std::endl;
+
+        if (avdc_icache) {
+                uint64_t fetches = avdc_icache->stat_data_read;
+                uint64_t fetch_misses = avdc_icache->stat_data_read_miss;
+
+                out << "Instruction cache statistics:" << std::endl;
+                out << "  Fetches: " << fetches << std::endl;
+                out << "  Fetch Misses: " << fetch_misses << std::endl;
+                out << "  Miss Ratio: " << ((100.0 * fetch_misses) / fetches) << "%" << std::endl;
+
+                avdc_delete(avdc_icache);
+        }
+
         avdc_delete(avdc);
 }
 
@@ -124,6 +350,38 @@ int main(int argc, char *argv[])
                 return -1;
         }
 
+        if (!knob_restore.Value().empty() &&
+            !avdc_restore(avdc, knob_restore.Value().c_str())) {
+                std::cerr << "Failed to restore cache snapshot." << std::endl;
+                return -1;
+        }
+
+        if (knob_icache.Value()) {
+                avdc_icache = avdc_new(knob_icache_size.Value(),
+                                       knob_icache_line_size.Value(),
+                                       knob_icache_associativity.Value());
+                if (!avdc_icache) {
+                        std::cerr << "Failed to initialize the instruction cache." << std::endl;
+                        return -1;
+                }
+                avdc_icache->dbg_name = "AVDC-I";
+        }
+
+        if (knob_roi.Value()) {
+                PIN_InitSymbols();
+                IMG_AddInstrumentFunction(image_load, 0);
+                phase = PHASE_FAST_FORWARD;
+        }
+
+        simulate_left = knob_length.Value();
+        if (knob_skip.Value()) {
+                phase = PHASE_FAST_FORWARD;
+                icount_left = knob_skip.Value();
+        } else if (phase == PHASE_SIMULATE) {
+                icount_left = simulate_left;
+        }
+
+        TRACE_AddInstrumentFunction(trace, 0);
         INS_AddInstrumentFunction(instruction, 0);
         PIN_AddFiniFunction(fini, 0);
 
@@ -0,0 +1,182 @@
+/**
+ * Cache simulator test case - Checkpoint/restore
+ *
+ * Course: Advanced Computer Architecture, Uppsala University
+ * Course Part: Lab assignment 1
+ *
+ */
+
+#include "avdark-cache.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <unistd.h>
+
+#define SNAPSHOT_PATH "test3.snapshot"
+
+#define STAT_ASSERT_EQ(a, b) do {                                       \
+                assert(a->stat_data_read == b->stat_data_read);         \
+                assert(a->stat_data_read_miss == b->stat_data_read_miss); \
+                assert(a->stat_data_write == b->stat_data_write);       \
+                assert(a->stat_data_write_miss == b->stat_data_write_miss); \
+        } while (0)
+
+#define COS_ASSERT_EQ(a, b) do {                                        \
+                for (int c = 0; c < AVDC_MAX_COS; c++) {                \
+                        assert(a->stat_cos_access[c] == b->stat_cos_access[c]); \
+                        assert(a->stat_cos_miss[c] == b->stat_cos_miss[c]); \
+                        assert(a->cos_mask[c] == b->cos_mask[c]);       \
+                }                                                       \
+        } while (0)
+
+/* Access a pseudo-random sequence of addresses, the same seed yields
+ * the same sequence. */
+static void
+random_accesses(avdark_cache_t *cache, unsigned short seed, int count)
+{
+        unsigned short xsubi[3] = { seed, seed, seed };
+        int i;
+
+        for (i = 0; i < count; i++) {
+                avdc_pa_t pa = nrand48(xsubi) & 0x3FFFFF;
+                avdc_access(cache, pa, (nrand48(xsubi) & 1) ? AVDC_WRITE : AVDC_READ);
+        }
+}
+
+static void
+test_checkpoint(avdc_size_t size, avdc_block_size_t block_size, avdc_assoc_t assoc)
+{
+        avdark_cache_t *warm, *restored;
+        int ok;
+
+        warm = avdc_new(size, block_size, assoc);
+        assert(warm);
+        avdc_print_info(warm);
+
+        /* Warm up the cache and save its state */
+        random_accesses(warm, 1, 100000);
+        ok = avdc_save(warm, SNAPSHOT_PATH);
+        assert(ok);
+
+        /* Restore the state into a cache with different parameters */
+        restored = avdc_new(512, 64, 1);
+        assert(restored);
+        ok = avdc_restore(restored, SNAPSHOT_PATH);
+        assert(ok);
+
+        assert(restored->size == warm->size &&
+               restored->block_size == warm->block_size &&
+               restored->assoc == warm->assoc);
+        assert(restored->number_of_sets == warm->number_of_sets);
+        STAT_ASSERT_EQ(warm, restored);
+
+        /* The restored cache must behave exactly like the warm one */
+        random_accesses(warm, 2, 100000);
+        random_accesses(restored, 2, 100000);
+        STAT_ASSERT_EQ(warm, restored);
+
+        avdc_delete(warm);
+        avdc_delete(restored);
+        unlink(SNAPSHOT_PATH);
+}
+
+/* Accesses by two classes of service, the same seed yields the same
+ * sequence */
+static void
+random_cos_accesses(avdark_cache_t *cache, unsigned short seed, int count)
+{
+        unsigned short xsubi[3] = { seed, seed, seed };
+        int i;
+
+        for (i = 0; i < count; i++) {
+                avdc_pa_t pa = nrand48(xsubi) & 0x3FFFFF;
+                avdc_access_cos(cache, pa, AVDC_READ, nrand48(xsubi) & 1);
+        }
+}
+
+/* The partitioning state and the per class statistics are part of the
+ * snapshot */
+static void
+test_checkpoint_ucp(void)
+{
+        avdark_cache_t *warm, *restored;
+        int ok;
+
+        warm = avdc_new(65536, 64, 8);
+        assert(warm);
+        ok = avdc_enable_ucp(warm, 2, 5000);
+        assert(ok);
+
+        /* Save in the middle of a UCP interval */
+        random_cos_accesses(warm, 1, 102500);
+        ok = avdc_save(warm, SNAPSHOT_PATH);
+        assert(ok);
+
+        /* The restored cache has stale per class statistics of its own */
+        restored = avdc_new(65536, 64, 8);
+        assert(restored);
+        random_cos_accesses(restored, 3, 1000);
+        ok = avdc_restore(restored, SNAPSHOT_PATH);
+        assert(ok);
+
+        assert(restored->ucp);
+        STAT_ASSERT_EQ(warm, restored);
+        COS_ASSERT_EQ(warm, restored);
+
+        /* Both caches must re-partition in the same way */
+        random_cos_accesses(warm, 2, 100000);
+        random_cos_accesses(restored, 2, 100000);
+        STAT_ASSERT_EQ(warm, restored);
+        COS_ASSERT_EQ(warm, restored);
+
+        /* A snapshot without UCP disables it */
+        ok = avdc_set_cos_mask(warm, 0, 0x3);
+        assert(ok);
+        ok = avdc_save(warm, SNAPSHOT_PATH);
+        assert(ok);
+        ok = avdc_restore(restored, SNAPSHOT_PATH);
+        assert(ok);
+        assert(!restored->ucp);
+        COS_ASSERT_EQ(warm, restored);
+
+        avdc_delete(warm);
+        avdc_delete(restored);
+        unlink(SNAPSHOT_PATH);
+}
+
+int
+main(int argc, char *argv[])
+{
+        avdark_cache_t *cache;
+        int ok;
+
+        printf("Checkpoint [direct mapped]\n");
+        test_checkpoint(8192, 64, 1);
+
+        printf("Checkpoint [associative]\n");
+        test_checkpoint(65536, 64, 8);
+
+        printf("Checkpoint [partitioned]\n");
+        test_checkpoint_ucp();
+
+        printf("Restore from missing snapshot\n");
+        cache = avdc_new(512, 64, 1);
+        assert(cache);
+        ok = avdc_restore(cache, SNAPSHOT_PATH);
+        assert(!ok);
+        avdc_delete(cache);
+
+        printf("%s done.\n", argv[0]);
+        return 0;
+}
+
+/*
+ * Local Variables:
+ * mode: c
+ * c-basic-offset: 8
+ * indent-tabs-mode: nil
+ * c-file-style: "linux"
+ * compile-command: "make -k -C ../../"
+ * End:
+ */
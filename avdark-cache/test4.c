@@ -0,0 +1,176 @@
+/**
+ * Cache simulator test case - Sharded multi-producer simulator
+ *
+ * Course: Advanced Computer Architecture, Uppsala University
+ * Course Part: Lab assignment 1
+ *
+ */
+
+#include "avdark-cache.h"
+#include "avdark-cache-sharded.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <time.h>
+#include <pthread.h>
+
+#define TRACE_LENGTH 2000000
+#define NO_PRODUCERS 4
+
+typedef struct {
+        avdc_pa_t          pa;
+        avdc_access_type_t type;
+        int                producer;
+} trace_entry_t;
+
+static trace_entry_t trace[TRACE_LENGTH];
+
+typedef struct {
+        avdc_sharded_t *sim;
+        int             producer;
+} producer_arg_t;
+
+/* Way masks used in the partitioned tests, producer p uses class p % 2 */
+static const avdc_way_mask_t partition_masks[2] = { 0x1, 0xE };
+
+/* Generate a trace with a mix of private streams and a shared hot
+ * region, interleaved pseudo-randomly between the producers. */
+static void
+generate_trace(void)
+{
+        unsigned short xsubi[3] = { 1, 2, 3 };
+
+        for (int i = 0; i < TRACE_LENGTH; i++) {
+                int producer = nrand48(xsubi) % NO_PRODUCERS;
+                avdc_pa_t pa;
+
+                if (nrand48(xsubi) & 1)
+                        pa = nrand48(xsubi) & 0xFFFF;
+                else
+                        pa = ((avdc_pa_t)producer << 24) | (nrand48(xsubi) & 0x3FFFFF);
+
+                trace[i].pa = pa;
+                trace[i].type = (nrand48(xsubi) & 3) ? AVDC_READ : AVDC_WRITE;
+                trace[i].producer = producer;
+        }
+}
+
+static void *
+producer_main(void *_arg)
+{
+        producer_arg_t *arg = _arg;
+
+        for (int i = 0; i < TRACE_LENGTH; i++) {
+                if (trace[i].producer == arg->producer)
+                        avdc_sharded_access(arg->sim, arg->producer, i,
+                                            trace[i].pa, trace[i].type);
+        }
+        avdc_sharded_producer_done(arg->sim, arg->producer);
+
+        return NULL;
+}
+
+static double
+time_diff(struct timespec *start, struct timespec *stop)
+{
+        return (stop->tv_sec - start->tv_sec) + (stop->tv_nsec - start->tv_nsec) * 1E-9;
+}
+
+static void
+test_sharded(avdark_cache_t *ref, int no_shards, int partitioned)
+{
+        avdc_sharded_t *sim;
+        pthread_t threads[NO_PRODUCERS];
+        producer_arg_t args[NO_PRODUCERS];
+        struct timespec start, stop;
+
+        sim = avdc_sharded_new(ref->size, ref->block_size, ref->assoc,
+                               no_shards, NO_PRODUCERS);
+        assert(sim);
+
+        if (partitioned) {
+                for (int c = 0; c < 2; c++) {
+                        int ok = avdc_sharded_set_cos_mask(sim, c, partition_masks[c]);
+                        assert(ok);
+                }
+                for (int p = 0; p < NO_PRODUCERS; p++)
+                        avdc_sharded_set_producer_cos(sim, p, p % 2);
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int p = 0; p < NO_PRODUCERS; p++) {
+                args[p].sim = sim;
+                args[p].producer = p;
+                pthread_create(&threads[p], NULL, producer_main, &args[p]);
+        }
+        for (int p = 0; p < NO_PRODUCERS; p++)
+                pthread_join(threads[p], NULL);
+        avdc_sharded_finish(sim);
+        clock_gettime(CLOCK_MONOTONIC, &stop);
+
+        printf("%d shard(s): %.1f Maccesses/s\n", no_shards,
+               TRACE_LENGTH / time_diff(&start, &stop) * 1E-6);
+
+        assert(sim->stat_data_read == ref->stat_data_read);
+        assert(sim->stat_data_read_miss == ref->stat_data_read_miss);
+        assert(sim->stat_data_write == ref->stat_data_write);
+        assert(sim->stat_data_write_miss == ref->stat_data_write_miss);
+        for (int c = 0; c < AVDC_MAX_COS; c++) {
+                assert(sim->stat_cos_access[c] == ref->stat_cos_access[c]);
+                assert(sim->stat_cos_miss[c] == ref->stat_cos_miss[c]);
+        }
+
+        avdc_sharded_delete(sim);
+}
+
+int
+main(int argc, char *argv[])
+{
+        avdark_cache_t *ref;
+
+        generate_trace();
+
+        ref = avdc_new(65536, 64, 4);
+        assert(ref);
+        avdc_print_info(ref);
+
+        /* Sequential reference simulation of the same interleaving */
+        for (int i = 0; i < TRACE_LENGTH; i++)
+                avdc_access(ref, trace[i].pa, trace[i].type);
+
+        for (int no_shards = 1; no_shards <= 8; no_shards *= 2) {
+                printf("Sharded [%d shard(s)]\n", no_shards);
+                test_sharded(ref, no_shards, 0);
+        }
+
+        /* Partitioned reference simulation */
+        avdc_flush_cache(ref);
+        avdc_reset_statistics(ref);
+        for (int c = 0; c < 2; c++) {
+                int ok = avdc_set_cos_mask(ref, c, partition_masks[c]);
+                assert(ok);
+        }
+        for (int i = 0; i < TRACE_LENGTH; i++)
+                avdc_access_cos(ref, trace[i].pa, trace[i].type, trace[i].producer % 2);
+
+        for (int no_shards = 1; no_shards <= 8; no_shards *= 2) {
+                printf("Sharded, partitioned [%d shard(s)]\n", no_shards);
+                test_sharded(ref, no_shards, 1);
+        }
+
+        avdc_delete(ref);
+
+        printf("%s done.\n", argv[0]);
+        return 0;
+}
+
+/*
+ * Local Variables:
+ * mode: c
+ * c-basic-offset: 8
+ * indent-tabs-mode: nil
+ * c-file-style: "linux"
+ * compile-command: "make -k -C ../../"
+ * End:
+ */
@@ -0,0 +1,176 @@
+/**
+ * Cache simulator test case - Cache partitioning
+ *
+ * Course: Advanced Computer Architecture, Uppsala University
+ * Course Part: Lab assignment 1
+ *
+ */
+
+#include "avdark-cache.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+
+static int
+popcount(avdc_way_mask_t mask)
+{
+        int count = 0;
+
+        for (; mask; mask >>= 1)
+                count += mask & 1;
+        return count;
+}
+
+/* A class confined to some ways may not evict lines belonging to
+ * other ways, but may hit in them. */
+static void
+test_static(avdark_cache_t *cache)
+{
+        const avdc_pa_t set_stride = cache->number_of_sets * cache->block_size;
+        avdc_assoc_t i;
+        int ok;
+
+        avdc_flush_cache(cache);
+        avdc_reset_statistics(cache);
+
+        ok = avdc_set_cos_mask(cache, 0, 0);
+        assert(!ok);
+        ok = avdc_set_cos_mask(cache, 0, 0x5);
+        assert(!ok);
+        ok = avdc_set_cos_mask(cache, 0, 0x1 << cache->assoc);
+        assert(!ok);
+        ok = avdc_set_cos_mask(cache, 0, 0x1);
+        assert(ok);
+        ok = avdc_set_cos_mask(cache, 1, ((1 << cache->assoc) - 1) & ~1);
+        assert(ok);
+
+        /* Class 0 owns way 0 */
+        avdc_access_cos(cache, 0, AVDC_READ, 0);
+
+        /* Class 1 streams through the same set */
+        for (i = 1; i <= 4 * cache->assoc; i++)
+                avdc_access_cos(cache, i * set_stride, AVDC_READ, 1);
+
+        avdc_access_cos(cache, 0, AVDC_READ, 0);
+        assert(cache->stat_cos_access[0] == 2 && cache->stat_cos_miss[0] == 1);
+        assert(cache->stat_cos_access[1] == 4 * cache->assoc &&
+               cache->stat_cos_miss[1] == 4 * cache->assoc);
+
+        /* Class 1 hits in the line owned by class 0 */
+        avdc_access_cos(cache, 0, AVDC_READ, 1);
+        assert(cache->stat_cos_miss[1] == 4 * cache->assoc);
+
+        /* Class 0 only has one way, so a conflict evicts its line */
+        avdc_access_cos(cache, set_stride * 1000, AVDC_READ, 0);
+        avdc_access_cos(cache, 0, AVDC_READ, 0);
+        assert(cache->stat_cos_miss[0] == 3);
+}
+
+/* Address ranges select the class of plain accesses */
+static void
+test_ranges(avdark_cache_t *cache)
+{
+        int ok;
+
+        avdc_flush_cache(cache);
+        avdc_reset_statistics(cache);
+
+        ok = avdc_add_cos_range(cache, 0x100000, 0x200000, 3);
+        assert(ok);
+        ok = avdc_add_cos_range(cache, 0x200000, 0x100000, 3);
+        assert(!ok);
+
+        avdc_access(cache, 0x100040, AVDC_WRITE);
+        avdc_access(cache, 0x100040, AVDC_READ);
+        avdc_access(cache, 0x300000, AVDC_READ);
+        assert(cache->stat_cos_access[3] == 2 && cache->stat_cos_miss[3] == 1);
+        assert(cache->stat_cos_access[0] == 1 && cache->stat_cos_miss[0] == 1);
+}
+
+/* Class 0 reuses 6 lines per set while class 1 streams, UCP should
+ * give class 0 the ways it needs. */
+static void
+test_ucp(void)
+{
+        avdark_cache_t *cache = avdc_new(65536, 64, 8);
+        const avdc_pa_t set_stride = cache->number_of_sets * cache->block_size;
+        avdc_pa_t stream = 0x10000000;
+        int round, set, way;
+        int ok;
+
+        assert(cache);
+        avdc_print_info(cache);
+        ok = avdc_enable_ucp(cache, 9, 1000);
+        assert(!ok);
+        ok = avdc_enable_ucp(cache, 2, 10000);
+        assert(ok);
+        assert(popcount(cache->cos_mask[0]) == 4 && popcount(cache->cos_mask[1]) == 4);
+
+        for (round = 0; round < 20; round++) {
+                for (set = 0; set < cache->number_of_sets; set++) {
+                        for (way = 0; way < 6; way++)
+                                avdc_access_cos(cache, way * set_stride + set * 64,
+                                                AVDC_READ, 0);
+                        for (way = 0; way < 6; way++, stream += 64)
+                                avdc_access_cos(cache, stream, AVDC_READ, 1);
+                }
+        }
+
+        printf("UCP: %d ways for the reusing class\n", popcount(cache->cos_mask[0]));
+        assert(popcount(cache->cos_mask[0]) >= 6);
+        assert(popcount(cache->cos_mask[1]) >= 1);
+        assert(!(cache->cos_mask[0] & cache->cos_mask[1]));
+        assert((cache->cos_mask[0] | cache->cos_mask[1]) == 0xFF);
+
+        /* Class 0 now fits, it should (almost) only hit */
+        avdc_reset_statistics(cache);
+        for (set = 0; set < cache->number_of_sets; set++) {
+                for (way = 0; way < 6; way++)
+                        avdc_access_cos(cache, way * set_stride + set * 64, AVDC_READ, 0);
+                for (way = 0; way < 6; way++, stream += 64)
+                        avdc_access_cos(cache, stream, AVDC_READ, 1);
+        }
+        assert(cache->stat_cos_miss[0] == 0);
+
+        /* Static masks disable UCP */
+        ok = avdc_set_cos_mask(cache, 0, 0xFF);
+        assert(ok);
+        assert(!cache->ucp);
+
+        avdc_delete(cache);
+}
+
+int
+main(int argc, char *argv[])
+{
+        avdark_cache_t *cache;
+
+        cache = avdc_new(8192, 64, 4);
+        assert(cache);
+        avdc_print_info(cache);
+
+        printf("Static partitioning\n");
+        test_static(cache);
+
+        printf("Address ranges\n");
+        test_ranges(cache);
+
+        avdc_delete(cache);
+
+        printf("Utility-based partitioning\n");
+        test_ucp();
+
+        printf("%s done.\n", argv[0]);
+        return 0;
+}
+
+/*
+ * Local Variables:
+ * mode: c
+ * c-basic-offset: 8
+ * indent-tabs-mode: nil
+ * c-file-style: "linux"
+ * compile-command: "make -k -C ../../"
+ * End:
+ */
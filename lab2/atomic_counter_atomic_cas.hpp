@@ -0,0 +1,52 @@
+#ifndef ATOMIC_COUNTER_ATOMIC_CAS_HPP
+#define ATOMIC_COUNTER_ATOMIC_CAS_HPP
+
+#include "atomic_counters.hpp"
+
+template <typename Order, typename Value, typename Backoff>
+inline atomic_counter_atomic_cas_t<Order, Value,
+                                   Backoff>::atomic_counter_atomic_cas_t()
+    : atomic_counter()
+    , m_value(0) {
+}
+
+// The initial load only provides a guess for the CAS, which validates it, so
+// it can be relaxed in all modes. A failed CAS reloads the value with the
+// load order of the policy and backs off before the next attempt.
+template <typename Order, typename Value, typename Backoff>
+inline int64_t atomic_counter_atomic_cas_t<Order, Value, Backoff>::increment() {
+    Value prev_value = m_value.load(std::memory_order_relaxed);
+    Backoff backoff(m_backoff);
+    while (!m_value.compare_exchange_weak(prev_value,
+                                          wrapping_add(prev_value, 1),
+                                          Order::rmw, Order::load)) {
+        backoff.pause();
+    }
+    return prev_value;
+}
+
+template <typename Order, typename Value, typename Backoff>
+inline int64_t atomic_counter_atomic_cas_t<Order, Value, Backoff>::decrement() {
+    Value prev_value = m_value.load(std::memory_order_relaxed);
+    Backoff backoff(m_backoff);
+    while (!m_value.compare_exchange_weak(prev_value,
+                                          wrapping_add(prev_value, -1),
+                                          Order::rmw, Order::load)) {
+        backoff.pause();
+    }
+    return prev_value;
+}
+
+template <typename Order, typename Value, typename Backoff>
+inline void
+atomic_counter_atomic_cas_t<Order, Value, Backoff>::set(int64_t value) {
+    // A 32-bit counter keeps the low 32 bits
+    m_value.store(Value(value), Order::store);
+}
+
+template <typename Order, typename Value, typename Backoff>
+inline int64_t atomic_counter_atomic_cas_t<Order, Value, Backoff>::get() {
+    return m_value.load(Order::load);
+}
+
+#endif // ATOMIC_COUNTER_ATOMIC_CAS_HPP
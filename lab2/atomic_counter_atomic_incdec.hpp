@@ -0,0 +1,38 @@
+#ifndef ATOMIC_COUNTER_ATOMIC_INCDEC_HPP
+#define ATOMIC_COUNTER_ATOMIC_INCDEC_HPP
+
+#include "atomic_counters.hpp"
+
+/* Bonus part 2: Memory Orderings*/
+/* The memory orders come from the Order policy, see order_relaxed in
+ * atomic_counters.hpp for when the relaxed counter is enough. Relaxed
+ * fetch_add/fetch_sub are still atomic, so no updates are lost. */
+
+template <typename Order, typename Value>
+inline atomic_counter_atomic_incdec_t<Order,
+                                      Value>::atomic_counter_atomic_incdec_t()
+    : m_value(0) {
+}
+
+template <typename Order, typename Value>
+inline int64_t atomic_counter_atomic_incdec_t<Order, Value>::increment() {
+    return m_value.fetch_add(1, Order::rmw);
+}
+
+template <typename Order, typename Value>
+inline int64_t atomic_counter_atomic_incdec_t<Order, Value>::decrement() {
+    return m_value.fetch_sub(1, Order::rmw);
+}
+
+template <typename Order, typename Value>
+inline void atomic_counter_atomic_incdec_t<Order, Value>::set(int64_t value) {
+    // A 32-bit counter keeps the low 32 bits
+    m_value.store(Value(value), Order::store);
+}
+
+template <typename Order, typename Value>
+inline int64_t atomic_counter_atomic_incdec_t<Order, Value>::get() {
+    return m_value.load(Order::load);
+}
+
+#endif // ATOMIC_COUNTER_ATOMIC_INCDEC_HPP
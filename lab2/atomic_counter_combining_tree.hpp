@@ -0,0 +1,156 @@
+#ifndef ATOMIC_COUNTER_COMBINING_TREE_HPP
+#define ATOMIC_COUNTER_COMBINING_TREE_HPP
+
+#include "atomic_counters.hpp"
+
+#include <cstdlib>
+#include <vector>
+
+// Implementation based on Herlihy and Shavit, "The Art of Multiprocessor
+// Programming", Figures 12.3 to 12.7. A combining operation goes through four
+// phases: precombining (climb the tree to find out how far we go), combining
+// (collect the values of threads that stopped at the nodes we pass), the
+// operation itself (at the root, or at the node where we hand our value to
+// another thread) and distribution of the results.
+
+inline bool atomic_counter_combining_tree::node::precombine() {
+    std::unique_lock<std::mutex> guard(m);
+    cv.wait(guard, [this] { return !locked; });
+    switch (cstatus) {
+    case status::idle:
+        cstatus = status::first;
+        return true;
+    case status::first:
+        // Another thread will carry our value up, prevent it from combining
+        // before we have deposited it
+        locked = true;
+        cstatus = status::second;
+        return false;
+    case status::root:
+        return false;
+    default:
+        abort();
+    }
+}
+
+inline int atomic_counter_combining_tree::node::combine(int combined) {
+    std::unique_lock<std::mutex> guard(m);
+    cv.wait(guard, [this] { return !locked; });
+    locked = true;
+    first_value = combined;
+    switch (cstatus) {
+    case status::first:
+        return first_value;
+    case status::second:
+        return first_value + second_value;
+    default:
+        abort();
+    }
+}
+
+inline int atomic_counter_combining_tree::node::op(int combined) {
+    std::unique_lock<std::mutex> guard(m);
+    switch (cstatus) {
+    case status::root: {
+        const int prior = result;
+        result = wrapping_add(result, combined);
+        return prior;
+    }
+    case status::second:
+        // Deposit our value and wait for the result
+        second_value = combined;
+        locked = false;
+        cv.notify_all();
+        cv.wait(guard, [this] { return cstatus == status::result; });
+        locked = false;
+        cv.notify_all();
+        cstatus = status::idle;
+        return result;
+    default:
+        abort();
+    }
+}
+
+inline void atomic_counter_combining_tree::node::distribute(int prior) {
+    std::unique_lock<std::mutex> guard(m);
+    switch (cstatus) {
+    case status::first:
+        // Nobody combined with us
+        cstatus = status::idle;
+        locked = false;
+        break;
+    case status::second:
+        // Our value was applied first, the second thread's right after it
+        result = wrapping_add(prior, first_value);
+        cstatus = status::result;
+        break;
+    default:
+        abort();
+    }
+    cv.notify_all();
+}
+
+inline atomic_counter_combining_tree::atomic_counter_combining_tree(int width)
+    : atomic_counter()
+    , m_nodes(new node[width - 1])
+    , m_leaves(new node *[(width + 1) / 2])
+    , m_width(width) {
+    m_nodes[0].cstatus = status::root;
+    for (int i = 1; i < width - 1; ++i) {
+        m_nodes[i].parent = &m_nodes[(i - 1) / 2];
+    }
+    for (int i = 0; i < (width + 1) / 2; ++i) {
+        m_leaves[i] = &m_nodes[width - 2 - i];
+    }
+}
+
+inline int atomic_counter_combining_tree::get_and_add(int delta) {
+    const int slot = this_thread_slot();
+    if (slot >= m_width) {
+        std::cerr << "More threads than the width of the combining tree\n";
+        abort();
+    }
+    node *leaf = m_leaves[slot / 2];
+
+    node *n = leaf;
+    while (n->precombine()) {
+        n = n->parent;
+    }
+    node *stop = n;
+
+    std::vector<node *> path;
+    int combined = delta;
+    for (n = leaf; n != stop; n = n->parent) {
+        combined = n->combine(combined);
+        path.push_back(n);
+    }
+
+    const int prior = stop->op(combined);
+
+    while (!path.empty()) {
+        path.back()->distribute(prior);
+        path.pop_back();
+    }
+
+    return prior;
+}
+
+inline int64_t atomic_counter_combining_tree::increment() {
+    return get_and_add(1);
+}
+
+inline int64_t atomic_counter_combining_tree::decrement() {
+    return get_and_add(-1);
+}
+
+inline void atomic_counter_combining_tree::set(int64_t value) {
+    std::lock_guard<std::mutex> guard(m_nodes[0].m);
+    m_nodes[0].result = value;
+}
+
+inline int64_t atomic_counter_combining_tree::get() {
+    std::lock_guard<std::mutex> guard(m_nodes[0].m);
+    return m_nodes[0].result;
+}
+
+#endif // ATOMIC_COUNTER_COMBINING_TREE_HPP
@@ -0,0 +1,72 @@
+#ifndef ATOMIC_COUNTER_DWCAS128_HPP
+#define ATOMIC_COUNTER_DWCAS128_HPP
+
+#include "atomic_counters.hpp"
+
+inline atomic_counter_dwcas128::atomic_counter_dwcas128()
+    : atomic_counter()
+    , m_state{0, 0} {
+}
+
+inline bool atomic_counter_dwcas128::dwcas(state &expected,
+                                           const state &desired) {
+#if defined(__x86_64__)
+    // GCC only inlines 16-byte atomics with -mcx16 and otherwise calls
+    // libatomic, so the instruction is spelled out. It is a full barrier
+    // like every locked instruction.
+    bool ok;
+    asm volatile("lock cmpxchg16b %1"
+                 : "=@ccz"(ok), "+m"(m_state), "+a"(expected.value),
+                   "+d"(expected.epoch)
+                 : "b"(desired.value), "c"(desired.epoch)
+                 : "memory");
+    return ok;
+#else
+    // AArch64 and others: GCC inlines the 16-byte __sync builtins (casp or
+    // an ldxp/stxp loop)
+    using pair = unsigned __int128;
+    pair old_pair, new_pair;
+    memcpy(&old_pair, &expected, sizeof(pair));
+    memcpy(&new_pair, &desired, sizeof(pair));
+    const pair prev = __sync_val_compare_and_swap(
+        reinterpret_cast<pair *>(&m_state), old_pair, new_pair);
+    if (prev == old_pair) {
+        return true;
+    }
+    memcpy(&expected, &prev, sizeof(pair));
+    return false;
+#endif
+}
+
+template <typename F>
+inline int64_t atomic_counter_dwcas128::update(F &&f) {
+    // The two loads may see the halves of different states, the CAS then
+    // fails and returns a consistent state
+    state prev = {__atomic_load_n(&m_state.value, __ATOMIC_RELAXED),
+                  __atomic_load_n(&m_state.epoch, __ATOMIC_RELAXED)};
+    while (!dwcas(prev, {f(prev.value), prev.epoch + 1})) {
+    }
+    return prev.value;
+}
+
+inline int64_t atomic_counter_dwcas128::increment() {
+    return update([](int64_t value) { return wrapping_add(value, 1); });
+}
+
+inline int64_t atomic_counter_dwcas128::decrement() {
+    return update([](int64_t value) { return wrapping_add(value, -1); });
+}
+
+inline void atomic_counter_dwcas128::set(int64_t value) {
+    update([value](int64_t) { return value; });
+}
+
+inline int64_t atomic_counter_dwcas128::get() {
+    return __atomic_load_n(&m_state.value, __ATOMIC_SEQ_CST);
+}
+
+inline uint64_t atomic_counter_dwcas128::epoch() {
+    return __atomic_load_n(&m_state.epoch, __ATOMIC_SEQ_CST);
+}
+
+#endif // ATOMIC_COUNTER_DWCAS128_HPP
@@ -0,0 +1,91 @@
+#ifndef ATOMIC_COUNTER_FLAT_COMBINING_HPP
+#define ATOMIC_COUNTER_FLAT_COMBINING_HPP
+
+#include "atomic_counters.hpp"
+
+template <typename Backoff>
+inline atomic_counter_flat_combining_t<
+    Backoff>::atomic_counter_flat_combining_t()
+    : atomic_counter()
+    , m_no_records(0)
+    , m_combiner(false)
+    , m_value(0) {
+    for (auto &r : m_records) {
+        r.req = none;
+        r.result = 0;
+    }
+}
+
+template <typename Backoff>
+inline int atomic_counter_flat_combining_t<Backoff>::apply(request req) {
+    const int slot = this_thread_slot();
+    record &r = m_records[slot];
+
+    int no_records = m_no_records.load(std::memory_order_relaxed);
+    while (no_records <= slot &&
+           !m_no_records.compare_exchange_weak(no_records, slot + 1,
+                                               std::memory_order_relaxed)) {
+    }
+
+    r.req.store(req, std::memory_order_release);
+    Backoff backoff(m_backoff);
+    while (r.req.load(std::memory_order_acquire) != none) {
+        if (m_combiner.load(std::memory_order_relaxed) ||
+            m_combiner.exchange(true, std::memory_order_acquire)) {
+            backoff.pause();
+            continue;
+        }
+
+        // We are the combiner, serve everybody including ourselves
+        const int n = m_no_records.load(std::memory_order_relaxed);
+        for (int i = 0; i < n; ++i) {
+            record &other = m_records[i];
+            const int op = other.req.load(std::memory_order_acquire);
+            if (op == none) {
+                continue;
+            }
+            other.result = m_value;
+            m_value = wrapping_add(m_value, op);
+            other.req.store(none, std::memory_order_release);
+        }
+
+        m_combiner.store(false, std::memory_order_release);
+    }
+
+    return r.result;
+}
+
+template <typename Backoff>
+inline int64_t atomic_counter_flat_combining_t<Backoff>::increment() {
+    return apply(inc);
+}
+
+template <typename Backoff>
+inline int64_t atomic_counter_flat_combining_t<Backoff>::decrement() {
+    return apply(dec);
+}
+
+template <typename Backoff>
+inline void atomic_counter_flat_combining_t<Backoff>::lock_combiner() {
+    Backoff backoff(m_backoff);
+    while (m_combiner.exchange(true, std::memory_order_acquire)) {
+        backoff.pause();
+    }
+}
+
+template <typename Backoff>
+inline void atomic_counter_flat_combining_t<Backoff>::set(int64_t value) {
+    lock_combiner();
+    m_value = value;
+    m_combiner.store(false, std::memory_order_release);
+}
+
+template <typename Backoff>
+inline int64_t atomic_counter_flat_combining_t<Backoff>::get() {
+    lock_combiner();
+    const int value = m_value;
+    m_combiner.store(false, std::memory_order_release);
+    return value;
+}
+
+#endif // ATOMIC_COUNTER_FLAT_COMBINING_HPP
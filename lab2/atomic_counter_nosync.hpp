@@ -0,0 +1,31 @@
+#ifndef ATOMIC_COUNTER_NOSYNC_HPP
+#define ATOMIC_COUNTER_NOSYNC_HPP
+
+#include "atomic_counters.hpp"
+
+inline atomic_counter_nosync::atomic_counter_nosync()
+    : atomic_counter()
+    , m_value(0) {
+}
+
+inline int64_t atomic_counter_nosync::increment() {
+    int prev_value = m_value;
+    m_value = wrapping_add(m_value, 1);
+    return prev_value;
+}
+
+inline int64_t atomic_counter_nosync::decrement() {
+    int prev_value = m_value;
+    m_value = wrapping_add(m_value, -1);
+    return prev_value;
+}
+
+inline void atomic_counter_nosync::set(int64_t value) {
+    m_value = value;
+}
+
+inline int64_t atomic_counter_nosync::get() {
+    return m_value;
+}
+
+#endif // ATOMIC_COUNTER_NOSYNC_HPP
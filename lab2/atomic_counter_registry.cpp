@@ -0,0 +1,31 @@
+#include "atomic_counters.hpp"
+
+template <typename Counter>
+static atomic_counter *create_counter() {
+    return new Counter();
+}
+
+template <typename List>
+struct registry_of;
+
+template <typename... Counters>
+struct registry_of<atomic_counter_list<Counters...>> {
+    static constexpr atomic_counter_info entries[] = {
+        {Counters::name, Counters::value_bits, create_counter<Counters>}...,
+        {nullptr, 0, nullptr},
+    };
+};
+
+const atomic_counter_info *const atomic_counter_registry =
+    registry_of<atomic_counter_types>::entries;
+
+atomic_counter *atomic_counter_create(const char *name) {
+    for (const atomic_counter_info *info = atomic_counter_registry; info->name;
+         ++info) {
+        if (strcmp(info->name, name) == 0) {
+            return info->create();
+        }
+    }
+
+    return nullptr;
+}
@@ -0,0 +1,44 @@
+#ifndef ATOMIC_COUNTER_SHARDED_HPP
+#define ATOMIC_COUNTER_SHARDED_HPP
+
+#include "atomic_counters.hpp"
+
+inline atomic_counter_sharded::atomic_counter_sharded()
+    : atomic_counter()
+    , m_base(0) {
+    for (auto &slot : m_slots) {
+        slot.value = 0;
+    }
+}
+
+inline int64_t atomic_counter_sharded::increment() {
+    // Only we write our slot, but get() reads the slots concurrently, so the
+    // add has to be atomic. The cache line stays in our cache in
+    // exclusive state, so this does not involve other cores.
+    std::atomic<int> &slot = m_slots[this_thread_slot()].value;
+    const int prev_slot = slot.fetch_add(1, std::memory_order_relaxed);
+    return wrapping_add(m_base.load(std::memory_order_relaxed), prev_slot);
+}
+
+inline int64_t atomic_counter_sharded::decrement() {
+    std::atomic<int> &slot = m_slots[this_thread_slot()].value;
+    const int prev_slot = slot.fetch_sub(1, std::memory_order_relaxed);
+    return wrapping_add(m_base.load(std::memory_order_relaxed), prev_slot);
+}
+
+inline void atomic_counter_sharded::set(int64_t value) {
+    for (auto &slot : m_slots) {
+        slot.value.store(0, std::memory_order_relaxed);
+    }
+    m_base.store(value, std::memory_order_relaxed);
+}
+
+inline int64_t atomic_counter_sharded::get() {
+    int value = m_base.load(std::memory_order_relaxed);
+    for (auto &slot : m_slots) {
+        value = wrapping_add(value, slot.value.load(std::memory_order_relaxed));
+    }
+    return value;
+}
+
+#endif // ATOMIC_COUNTER_SHARDED_HPP
@@ -2,12 +2,30 @@
 #define ATOMIC_COUNTERS_HPP
 
 #include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <memory>
 #include <mutex>
+#include <type_traits>
+
+#include "backoff.hpp"
+#include "sync_common.hpp"
 
 /*******************************************************************************
  *                             Base Abstract Class                             *
  ******************************************************************************/
 
+// The counters below derive from atomic_counter so that they can be selected
+// at runtime (see atomic_counter_create()). They are all final and
+// implemented in headers, so code that knows the concrete counter type calls
+// them without going through the vtable and can inline them (see
+// atomic_counter_visit()).
+//
+// The interface uses 64-bit values. Every counter also gives the width of
+// the value it stores as value_bits, a 32-bit counter wraps around like an
+// int and set() keeps the low 32 bits of its argument.
+
 class atomic_counter {
 public:
     /**
@@ -25,7 +43,7 @@ public:
      * Returns:
      *	The value of the counter just before it was incremented.
      */
-    virtual int increment() = 0;
+    virtual int64_t increment() = 0;
 
     /**
      * This function atomically decrements the counter and returns the value
@@ -42,7 +60,7 @@ public:
      * Returns:
      *	The value of the counter just before it was decremented.
      */
-    virtual int decrement() = 0;
+    virtual int64_t decrement() = 0;
 
     /**
      * This function atomically sets the counter to the given value. E.g.:
@@ -56,7 +74,7 @@ public:
      * Returns:
      *	Nothing
      */
-    virtual void set(int value) = 0;
+    virtual void set(int64_t value) = 0;
 
     /**
      * This function atomically gets the counter value.
@@ -67,82 +85,514 @@ public:
      * Returns:
      *	The value of the counter (m_value).
      */
-    virtual int get() = 0;
+    virtual int64_t get() = 0;
 
     virtual ~atomic_counter(){};
 };
 
+/*******************************************************************************
+ *                              Counter registry                               *
+ ******************************************************************************/
+
+struct atomic_counter_info {
+    // Name used to select the counter in the tests and benchmarks
+    const char *name;
+    // Width of the counter value, 32, 64 or 128 bits (value and tag)
+    int value_bits;
+    atomic_counter *(*create)();
+};
+
+// All available counters, terminated by an entry with name == nullptr
+extern const atomic_counter_info *const atomic_counter_registry;
+
+/**
+ * This function creates a counter by name. E.g.:
+ *
+ * std::unique_ptr<atomic_counter> counter(atomic_counter_create("lock"));
+ *
+ * Returns:
+ *	The new counter, or nullptr if there is no counter with that name.
+ */
+atomic_counter *atomic_counter_create(const char *name);
+
+// Returns value + delta, wrapping around like the fetch_add of std::atomic.
+// The counters use it for all updates of their values, as a plain signed
+// addition that overflows is undefined behaviour.
+template <typename Value>
+inline Value wrapping_add(Value value, int delta) {
+    using Unsigned = std::make_unsigned_t<Value>;
+    return Value(Unsigned(value) + Unsigned(delta));
+}
+
 /*******************************************************************************
  *                             No Synchronization                              *
  ******************************************************************************/
 
-class atomic_counter_nosync : public atomic_counter {
+class atomic_counter_nosync final : public atomic_counter {
 private:
     int m_value;
 
 public:
+    static constexpr const char *name = "nosync";
+    static constexpr int value_bits = 32;
+
     atomic_counter_nosync();
 
-    int increment() override;
-    int decrement() override;
+    int64_t increment() override;
+    int64_t decrement() override;
 
-    void set(int value) override;
-    int get() override;
+    void set(int64_t value) override;
+    int64_t get() override;
 };
 
 /*******************************************************************************
  *                         Lock-based Synchronization                          *
  ******************************************************************************/
 
-class atomic_counter_lock : public atomic_counter {
+class atomic_counter_lock final : public atomic_counter {
 private:
     int m_value;
     std::mutex m_lock;
 
 public:
+    static constexpr const char *name = "lock";
+    static constexpr int value_bits = 32;
+
     atomic_counter_lock();
 
-    int increment() override;
-    int decrement() override;
+    int64_t increment() override;
+    int64_t decrement() override;
 
-    void set(int value) override;
-    int get() override;
+    void set(int64_t value) override;
+    int64_t get() override;
+};
+
+/*******************************************************************************
+ *                           Memory order policies                             *
+ ******************************************************************************/
+
+// The single-word atomic counters are templates on one of these policies,
+// which give the memory order of their read-modify-write operations (rmw),
+// get() (load) and set() (store).
+//
+// order_seq_cst: all operations take part in the single total order of
+// seq_cst operations. The default, and what the counters did before the
+// policies existed.
+//
+// order_acq_rel: the updates synchronize with each other and with get(),
+// so writes made before an update are visible after a later update or
+// get() that reads its value. Enough when the counter value hands off other
+// data, e.g. a reference count whose last decrement frees an object.
+//
+// order_relaxed: only the counter itself is consistent. The updates are
+// still atomic, no update is lost and every update returns a distinct prior
+// value, but they order no other memory accesses. This is the mode for
+// statistics (event counts, bytes transferred, ...) that are only read as
+// numbers and never used to decide whether other data is ready. On x86 the
+// RMWs compile to the same lock-prefixed instructions in all three modes.
+// On weakly ordered CPUs such as ARM the relaxed mode drops the barriers or
+// acquire/release variants of the instructions (see make arm_counters).
+struct order_seq_cst {
+    static constexpr std::memory_order rmw = std::memory_order_seq_cst;
+    static constexpr std::memory_order load = std::memory_order_seq_cst;
+    static constexpr std::memory_order store = std::memory_order_seq_cst;
+};
+
+struct order_acq_rel {
+    static constexpr std::memory_order rmw = std::memory_order_acq_rel;
+    static constexpr std::memory_order load = std::memory_order_acquire;
+    static constexpr std::memory_order store = std::memory_order_release;
+};
+
+struct order_relaxed {
+    static constexpr std::memory_order rmw = std::memory_order_relaxed;
+    static constexpr std::memory_order load = std::memory_order_relaxed;
+    static constexpr std::memory_order store = std::memory_order_relaxed;
 };
 
 /*******************************************************************************
  *              Atomic Increment/Decrement-based Synchronization               *
  ******************************************************************************/
 
-class atomic_counter_atomic_incdec : public atomic_counter {
+// Value is the type of the counter value, int or int64_t. A 32-bit counter
+// of events wraps within seconds to hours at high event rates, a 64-bit one
+// only after centuries.
+//
+// The registry names of the instances, the other combinations have no name
+// and are not registered.
+template <typename Order, typename Value>
+inline constexpr const char *atomic_incdec_name = nullptr;
+template <>
+inline constexpr const char *atomic_incdec_name<order_seq_cst, int> =
+    "atomic_incdec";
+template <>
+inline constexpr const char *atomic_incdec_name<order_acq_rel, int> =
+    "atomic_incdec_acq_rel";
+template <>
+inline constexpr const char *atomic_incdec_name<order_relaxed, int> =
+    "atomic_incdec_relaxed";
+template <>
+inline constexpr const char *atomic_incdec_name<order_seq_cst, int64_t> =
+    "atomic_incdec64";
+template <>
+inline constexpr const char *atomic_incdec_name<order_relaxed, int64_t> =
+    "atomic_incdec64_relaxed";
+
+template <typename Order, typename Value>
+class atomic_counter_atomic_incdec_t final : public atomic_counter {
 private:
-    std::atomic<int> m_value; // TODO: Change type
+    std::atomic<Value> m_value;
 
 public:
-    atomic_counter_atomic_incdec();
+    static constexpr const char *name = atomic_incdec_name<Order, Value>;
+    static constexpr int value_bits = 8 * sizeof(Value);
 
-    int increment() override;
-    int decrement() override;
+    atomic_counter_atomic_incdec_t();
 
-    void set(int value) override;
-    int get() override;
+    int64_t increment() override;
+    int64_t decrement() override;
+
+    void set(int64_t value) override;
+    int64_t get() override;
 };
 
+using atomic_counter_atomic_incdec =
+    atomic_counter_atomic_incdec_t<order_seq_cst, int>;
+using atomic_counter_atomic_incdec_acq_rel =
+    atomic_counter_atomic_incdec_t<order_acq_rel, int>;
+using atomic_counter_atomic_incdec_relaxed =
+    atomic_counter_atomic_incdec_t<order_relaxed, int>;
+using atomic_counter_atomic_incdec64 =
+    atomic_counter_atomic_incdec_t<order_seq_cst, int64_t>;
+using atomic_counter_atomic_incdec64_relaxed =
+    atomic_counter_atomic_incdec_t<order_relaxed, int64_t>;
+
 /*******************************************************************************
  *                      Atomic CAS-based Synchronization                       *
  ******************************************************************************/
 
-class atomic_counter_atomic_cas : public atomic_counter {
+// Backoff is the policy for the retries after a failed CAS, see backoff.hpp.
+// The instances with backoff are registered with seq_cst order only.
+template <typename Order, typename Value, typename Backoff = backoff_none>
+inline constexpr const char *atomic_cas_name = nullptr;
+template <>
+inline constexpr const char *atomic_cas_name<order_seq_cst, int> = "atomic_cas";
+template <>
+inline constexpr const char *atomic_cas_name<order_acq_rel, int> =
+    "atomic_cas_acq_rel";
+template <>
+inline constexpr const char *atomic_cas_name<order_relaxed, int> =
+    "atomic_cas_relaxed";
+template <>
+inline constexpr const char *atomic_cas_name<order_seq_cst, int64_t> =
+    "atomic_cas64";
+template <>
+inline constexpr const char
+    *atomic_cas_name<order_seq_cst, int, backoff_pause> = "atomic_cas_pause";
+template <>
+inline constexpr const char *atomic_cas_name<order_seq_cst, int, backoff_exp> =
+    "atomic_cas_exp";
+template <>
+inline constexpr const char
+    *atomic_cas_name<order_seq_cst, int, backoff_adaptive> =
+        "atomic_cas_adaptive";
+
+template <typename Order, typename Value, typename Backoff = backoff_none>
+class atomic_counter_atomic_cas_t final : public atomic_counter {
+private:
+    std::atomic<Value> m_value;
+    typename Backoff::state m_backoff;
+
+public:
+    static constexpr const char *name = atomic_cas_name<Order, Value, Backoff>;
+    static constexpr int value_bits = 8 * sizeof(Value);
+
+    atomic_counter_atomic_cas_t();
+
+    int64_t increment() override;
+    int64_t decrement() override;
+
+    void set(int64_t value) override;
+    int64_t get() override;
+};
+
+using atomic_counter_atomic_cas =
+    atomic_counter_atomic_cas_t<order_seq_cst, int>;
+using atomic_counter_atomic_cas_acq_rel =
+    atomic_counter_atomic_cas_t<order_acq_rel, int>;
+using atomic_counter_atomic_cas_relaxed =
+    atomic_counter_atomic_cas_t<order_relaxed, int>;
+using atomic_counter_atomic_cas64 =
+    atomic_counter_atomic_cas_t<order_seq_cst, int64_t>;
+using atomic_counter_atomic_cas_pause =
+    atomic_counter_atomic_cas_t<order_seq_cst, int, backoff_pause>;
+using atomic_counter_atomic_cas_exp =
+    atomic_counter_atomic_cas_t<order_seq_cst, int, backoff_exp>;
+using atomic_counter_atomic_cas_adaptive =
+    atomic_counter_atomic_cas_t<order_seq_cst, int, backoff_adaptive>;
+
+/*******************************************************************************
+ *                    Double-width CAS with an update tag                      *
+ ******************************************************************************/
+
+class atomic_counter_dwcas128 final : public atomic_counter {
 private:
-    std::atomic<int> m_value; // TODO: Change type
-  
+    // A 64-bit value and a tag that counts the updates, changed together by
+    // a 16-byte CAS (cmpxchg16b on x86-64). The tag makes every state
+    // unique: a thread that read (value, epoch) knows the counter has not
+    // changed in between if the epoch is still the same, even if the value
+    // has come back to what it was (ABA). The halves are read with 64-bit
+    // atomic loads.
+    struct alignas(16) state {
+        int64_t value;
+        uint64_t epoch;
+    };
+    alignas(CACHE_LINE_SIZE) state m_state;
+
+    // Replaces m_state with desired if it is equal to expected, otherwise
+    // loads it into expected
+    bool dwcas(state &expected, const state &desired);
+
+    // Applies f to the value and returns the prior value
+    template <typename F>
+    int64_t update(F &&f);
+
 public:
-    atomic_counter_atomic_cas();
+    static constexpr const char *name = "dwcas128";
+    static constexpr int value_bits = 128;
+
+    atomic_counter_dwcas128();
 
-    int increment() override;
-    int decrement() override;
+    int64_t increment() override;
+    int64_t decrement() override;
 
-    void set(int value) override;
-    int get() override;
+    void set(int64_t value) override;
+    int64_t get() override;
+
+    // The number of updates since the counter was created, set() included
+    uint64_t epoch();
 };
 
+/*******************************************************************************
+ *                    Sharded counter with per-thread slots                    *
+ ******************************************************************************/
+
+class atomic_counter_sharded final : public atomic_counter {
+private:
+    // The counter value is m_base plus the sum of all slots. Every thread
+    // updates the slot of its this_thread_slot() id, so increments and
+    // decrements never contend for a cache line. A slot keeps its value
+    // when its thread exits and is reused by a later thread.
+    padded<std::atomic<int>> m_slots[MAX_THREADS];
+    alignas(CACHE_LINE_SIZE) std::atomic<int> m_base;
+
+public:
+    static constexpr const char *name = "sharded";
+    static constexpr int value_bits = 32;
+
+    atomic_counter_sharded();
+
+    /**
+     * Unlike the other counters, the value returned by increment() and
+     * decrement() is only exact as long as no other thread modifies the
+     * counter: it is the value the counter would have had just before the
+     * update if only the calling thread had modified it since the last
+     * set(). Use get() to read the total.
+     */
+    int64_t increment() override;
+    int64_t decrement() override;
+
+    /**
+     * set() must not run concurrently with any other operation on the
+     * counter. get() sums all slots, it is exact when no updates are in
+     * progress. Updates that run concurrently with get() may or may not be
+     * included in the sum.
+     */
+    void set(int64_t value) override;
+    int64_t get() override;
+};
+
+/*******************************************************************************
+ *                           Software combining tree                           *
+ ******************************************************************************/
+
+class atomic_counter_combining_tree final : public atomic_counter {
+private:
+    // Based on Herlihy and Shavit, "The Art of Multiprocessor Programming",
+    // Sec. 12.3. Two threads share every leaf. Threads climb the tree until
+    // they meet a node no other thread has passed, the last thread to arrive
+    // at a node carries the combined updates of both up towards the root.
+    // Only the thread reaching the root updates the counter, the results are
+    // then handed back down the tree.
+    enum class status { idle, first, second, result, root };
+
+    struct node {
+        std::mutex m;
+        std::condition_variable cv;
+        // Set while the node is part of a combining operation that has to
+        // finish before another one may start using it
+        bool locked = false;
+        status cstatus = status::idle;
+        int first_value = 0;
+        int second_value = 0;
+        // The counter value in the root. In other nodes: the result for
+        // the second thread.
+        int result = 0;
+        node *parent = nullptr;
+
+        bool precombine();
+        int combine(int combined);
+        int op(int combined);
+        void distribute(int prior);
+    };
+
+    std::unique_ptr<node[]> m_nodes;
+    // Leaf used by thread slot i is m_leaves[i / 2]
+    std::unique_ptr<node *[]> m_leaves;
+    int m_width;
+
+    // Adds delta to the counter and returns the prior value
+    int get_and_add(int delta);
+
+public:
+    static constexpr const char *name = "combining_tree";
+    static constexpr int value_bits = 32;
+
+    // width: the maximum number of threads using the counter at the same time
+    explicit atomic_counter_combining_tree(int width = MAX_THREADS);
+
+    int64_t increment() override;
+    int64_t decrement() override;
+
+    // set() must not run concurrently with increment() and decrement()
+    void set(int64_t value) override;
+    int64_t get() override;
+};
+
+/*******************************************************************************
+ *                         Flat-combining counter                              *
+ ******************************************************************************/
+
+// Backoff is the policy for the waits for the combiner, see backoff.hpp. The
+// plain name is the instance with backoff_pause.
+template <typename Backoff>
+inline constexpr const char *flat_combining_name = nullptr;
+template <>
+inline constexpr const char *flat_combining_name<backoff_pause> =
+    "flat_combining";
+template <>
+inline constexpr const char *flat_combining_name<backoff_exp> =
+    "flat_combining_exp";
+template <>
+inline constexpr const char *flat_combining_name<backoff_adaptive> =
+    "flat_combining_adaptive";
+
+template <typename Backoff>
+class atomic_counter_flat_combining_t final : public atomic_counter {
+private:
+    // Hendler et al., "Flat Combining and the Synchronization-Parallelism
+    // Tradeoff". Threads publish their operation in a record of their own and
+    // then either wait for it to be completed or, if nobody else is, become
+    // the combiner: take the lock, apply the pending operations of all
+    // threads to m_value and hand back the results.
+    enum request : int { none = 0, inc = 1, dec = -1 };
+
+    struct alignas(CACHE_LINE_SIZE) record {
+        std::atomic<int> req;
+        int result;
+    };
+    record m_records[MAX_THREADS];
+
+    // Records above this slot have never been used, the combiner doesn't
+    // scan them
+    alignas(CACHE_LINE_SIZE) std::atomic<int> m_no_records;
+
+    // The combiner lock and the counter value it protects
+    alignas(CACHE_LINE_SIZE) std::atomic<bool> m_combiner;
+    int m_value;
+
+    typename Backoff::state m_backoff;
+
+    int apply(request req);
+    // Takes the combiner lock
+    void lock_combiner();
+
+public:
+    static constexpr const char *name = flat_combining_name<Backoff>;
+    static constexpr int value_bits = 32;
+
+    atomic_counter_flat_combining_t();
+
+    int64_t increment() override;
+    int64_t decrement() override;
+
+    void set(int64_t value) override;
+    int64_t get() override;
+};
+
+using atomic_counter_flat_combining =
+    atomic_counter_flat_combining_t<backoff_pause>;
+using atomic_counter_flat_combining_exp =
+    atomic_counter_flat_combining_t<backoff_exp>;
+using atomic_counter_flat_combining_adaptive =
+    atomic_counter_flat_combining_t<backoff_adaptive>;
+
+/*******************************************************************************
+ *                         Implementations and dispatch                        *
+ ******************************************************************************/
+
+#include "atomic_counter_atomic_cas.hpp"
+#include "atomic_counter_atomic_incdec.hpp"
+#include "atomic_counter_combining_tree.hpp"
+#include "atomic_counter_dwcas128.hpp"
+#include "atomic_counter_flat_combining.hpp"
+#include "atomic_counter_lock.hpp"
+#include "atomic_counter_nosync.hpp"
+#include "atomic_counter_sharded.hpp"
+
+template <typename... Counters>
+struct atomic_counter_list {};
+
+// All counters, in the order in which they are listed in
+// atomic_counter_registry
+using atomic_counter_types = atomic_counter_list<
+    atomic_counter_nosync, atomic_counter_lock, atomic_counter_atomic_incdec,
+    atomic_counter_atomic_cas, atomic_counter_sharded,
+    atomic_counter_combining_tree, atomic_counter_flat_combining,
+    atomic_counter_atomic_incdec_acq_rel, atomic_counter_atomic_incdec_relaxed,
+    atomic_counter_atomic_cas_acq_rel, atomic_counter_atomic_cas_relaxed,
+    atomic_counter_atomic_incdec64, atomic_counter_atomic_incdec64_relaxed,
+    atomic_counter_atomic_cas64, atomic_counter_dwcas128,
+    atomic_counter_atomic_cas_pause, atomic_counter_atomic_cas_exp,
+    atomic_counter_atomic_cas_adaptive, atomic_counter_flat_combining_exp,
+    atomic_counter_flat_combining_adaptive>;
+
+template <typename F, typename... Counters>
+bool atomic_counter_visit(atomic_counter_list<Counters...>, const char *name,
+                          F &f) {
+    auto visit_one = [&](auto *type_tag) {
+        using Counter = std::remove_pointer_t<decltype(type_tag)>;
+        if (strcmp(name, Counter::name) != 0) {
+            return false;
+        }
+        std::unique_ptr<Counter> counter(new Counter());
+        f(*counter);
+        return true;
+    };
+    return (visit_one(static_cast<Counters *>(nullptr)) || ...);
+}
+
+/**
+ * This function creates a counter by name, like atomic_counter_create(), and
+ * calls f with a reference of the counter's concrete type, see
+ * user_lock_visit().
+ *
+ * Returns:
+ *	false if there is no counter with that name.
+ */
+template <typename F>
+bool atomic_counter_visit(const char *name, F &&f) {
+    return atomic_counter_visit(atomic_counter_types(), name, f);
+}
+
 #endif // ATOMIC_COUNTERS_HPP
@@ -0,0 +1,161 @@
+#ifndef BACKOFF_HPP
+#define BACKOFF_HPP
+
+// Backoff policies for spin loops and CAS retry loops. The spinning locks, the
+// CAS counter and the flat-combining counter take one of them as a template
+// parameter and use it like this:
+//
+//	Backoff backoff(m_backoff);
+//	while (!ready()) {
+//	    backoff.pause();
+//	}
+//
+// A policy object lives for one wait, from the first check until the wait is
+// over. m_backoff is the policy's state that outlives a wait (see
+// Backoff::state), it is kept in the lock or counter.
+//
+// backoff_none:     poll as fast as possible, what the loops did before.
+// backoff_pause:    one pause instruction between two polls (cpu_relax()).
+//                   Leaves the core's execution resources to an SMT sibling
+//                   and avoids the memory order mis-speculation when the
+//                   loop exits.
+// backoff_exp:      exponential backoff with jitter. The delay doubles with
+//                   every retry, up to max_delay pauses, and is drawn at
+//                   random from its upper half, so that threads that failed
+//                   together do not retry together.
+// backoff_adaptive: like backoff_exp, but the first delay is not the minimum
+//                   but the delay that recent waits on the same lock or
+//                   counter ended with. Under sustained contention a thread
+//                   starts with a long delay instead of hammering the cache
+//                   line for several rounds first, and the delay shrinks
+//                   again as the contention goes away.
+//
+// Backing off is a trade-off: it reduces the traffic on contended cache lines
+// and frees the core for an SMT sibling, but a thread that is backing off
+// notices late that it could proceed. The queue locks spin on a flag of their
+// own, so for them only the pause matters. See make bench_backoff.
+
+#include "sync_common.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+/*******************************************************************************
+ *                                  Policies                                   *
+ ******************************************************************************/
+
+struct backoff_none {
+    static constexpr const char *name = "none";
+
+    struct state {};
+
+    explicit backoff_none(state &) {
+    }
+
+    void pause() {
+    }
+};
+
+struct backoff_pause {
+    static constexpr const char *name = "pause";
+
+    struct state {};
+
+    explicit backoff_pause(state &) {
+    }
+
+    void pause() {
+        cpu_relax();
+    }
+};
+
+// Shared by backoff_exp and backoff_adaptive: waits for a random number of
+// pauses from the upper half of the current delay, then doubles the delay
+class backoff_jittered {
+public:
+    // In pause instructions, a pause takes about 10 to 150 cycles depending
+    // on the CPU
+    static constexpr unsigned min_delay = 4;
+    static constexpr unsigned max_delay = 1024;
+
+protected:
+    unsigned m_delay;
+    // xorshift32 state, seeded from the address of the policy object, which
+    // lives on the stack of the waiting thread
+    uint32_t m_rng;
+
+    explicit backoff_jittered(unsigned delay)
+        : m_delay(delay)
+        , m_rng(uint32_t(reinterpret_cast<uintptr_t>(this) >> 4) * 2654435761u |
+                1) {
+    }
+
+public:
+    void pause() {
+        m_rng ^= m_rng << 13;
+        m_rng ^= m_rng >> 17;
+        m_rng ^= m_rng << 5;
+        const unsigned pauses = m_delay / 2 + m_rng % (m_delay / 2 + 1);
+        for (unsigned i = 0; i < pauses; ++i) {
+            cpu_relax();
+        }
+        m_delay = std::min(2 * m_delay, max_delay);
+    }
+};
+
+struct backoff_exp : backoff_jittered {
+    static constexpr const char *name = "exp";
+
+    struct state {};
+
+    explicit backoff_exp(state &)
+        : backoff_jittered(min_delay) {
+    }
+};
+
+struct backoff_adaptive : backoff_jittered {
+    static constexpr const char *name = "adaptive";
+
+    // The delay to start the next wait with. Updated racily when a wait is
+    // over, it is only a hint. In a cache line of its own, so that the
+    // updates do not invalidate the line of the lock or counter.
+    struct alignas(CACHE_LINE_SIZE) state {
+        std::atomic<unsigned> delay{min_delay};
+    };
+
+    explicit backoff_adaptive(state &s)
+        : backoff_jittered(s.delay.load(std::memory_order_relaxed))
+        , m_state(s)
+        , m_start_delay(m_delay) {
+    }
+
+    void pause() {
+        m_last_delay = m_delay;
+        m_retries++;
+        backoff_jittered::pause();
+    }
+
+    // A wait that needed more than one retry starts the next one with the
+    // delay of its last retry, the one that let it proceed. A wait that
+    // needed no retry at all halves the start delay.
+    ~backoff_adaptive() {
+        unsigned delay = m_start_delay;
+        if (m_retries > 1) {
+            delay = m_last_delay;
+        } else if (m_retries == 0) {
+            delay = std::max(m_start_delay / 2, min_delay);
+        }
+        if (delay != m_start_delay) {
+            m_state.delay.store(delay, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    state &m_state;
+    unsigned m_start_delay;
+    unsigned m_last_delay = 0;
+    unsigned m_retries = 0;
+};
+
+#endif // BACKOFF_HPP
@@ -0,0 +1,78 @@
+#include "atomic_counters.hpp"
+#include "bench_common.hpp"
+
+// Throughput sweep for the atomic counters. Threads with even ids increment
+// and threads with odd ids decrement the counter, as in test_atomic_counter,
+// on any number of threads. The critical section knob has no effect, the
+// counter operation is the critical section.
+
+void usage(char *argv[]) {
+    std::cerr << "Usage: " << argv[0] << " [OPTIONS] <COUNTER>\n\n"
+              << "Where <COUNTER> can be:\n";
+    for (const atomic_counter_info *info = atomic_counter_registry; info->name;
+         ++info) {
+        std::cerr << "\t" << info->name << "\n";
+    }
+    std::cerr << "\n" << bench_options_usage();
+}
+
+int main(int argc, char *argv[]) {
+    bench_options opt;
+    if (!parse_bench_options(argc, argv, opt) || optind != argc - 1) {
+        usage(argv);
+        return -1;
+    }
+    const char *name = argv[optind];
+
+    bench_reporter reporter(opt, name);
+    for (int threads : opt.threads) {
+        bool ok = true;
+        // Instantiated for every counter type, and for atomic_counter with
+        // --virtual
+        auto run = [&](auto &counter) {
+            bench_result r = bench_run(opt, threads, [&](int tid) {
+                if (tid % 2 == 0) {
+                    counter.increment();
+                } else {
+                    counter.decrement();
+                }
+            });
+
+            long expected = 0;
+            for (int tid = 0; tid < threads; ++tid) {
+                expected += tid % 2 == 0 ? long(r.per_thread[tid].ops)
+                                         : -long(r.per_thread[tid].ops);
+            }
+            // The narrowest counters are 32 bits, compare modulo 2^32
+            if (int(expected) != int(counter.get())) {
+                std::cerr << "Lost updates: expected " << int(expected)
+                          << " but counter is " << counter.get() << "\n";
+                ok = false;
+                return;
+            }
+
+            reporter.report(r);
+        };
+
+        bool found;
+        if (opt.virtual_dispatch) {
+            std::unique_ptr<atomic_counter> counter(
+                atomic_counter_create(name));
+            if ((found = counter != nullptr)) {
+                run(*counter);
+            }
+        } else {
+            found = atomic_counter_visit(name, run);
+        }
+        if (!found) {
+            std::cerr << "Invalid <COUNTER> " << name << "\n";
+            usage(argv);
+            return -1;
+        }
+        if (!ok) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,538 @@
+#ifndef BENCH_COMMON_HPP
+#define BENCH_COMMON_HPP
+
+// Shared driver for the lab2 benchmarks. A benchmark supplies a function that
+// performs one operation (e.g. acquire, update and release a lock) and the
+// driver runs it on a sweep of thread counts for a fixed time each, pins the
+// threads according to a policy, adds think time between the operations and
+// collects per-thread throughput, fairness and latency histograms.
+//
+// Common command line options, parsed by parse_bench_options():
+//
+//	--threads=1,2,8     Thread counts to run (default: 1, 2, 4, ... up to
+//	                    --max-threads)
+//	--max-threads=N     Largest thread count of the default sweep (default:
+//	                    the number of CPUs)
+//	--pin=POLICY        none, compact, scatter or smt (default: none)
+//	--cs=N              Work inside the critical section, in loop iterations
+//	--think=N           Work between two operations, in loop iterations
+//	--duration=MS       Duration of every run (default: 1000)
+//	--csv               Print CSV instead of a table
+//	--hist=FILE         Write the latency histograms to FILE as CSV
+//	--virtual           Call the implementation through its virtual base
+//	                    class instead of the concrete type
+
+#include "latency_histogram.hpp"
+#include "sync_common.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <getopt.h>
+#include <pthread.h>
+#include <sched.h>
+
+using bench_clock = std::chrono::steady_clock;
+
+/*******************************************************************************
+ *                                   Options                                   *
+ ******************************************************************************/
+
+enum class pin_policy { none, compact, scatter, smt };
+
+struct bench_options {
+    std::vector<int> threads;
+    int max_threads = 0;
+    pin_policy pin = pin_policy::none;
+    const char *pin_name = "none";
+    unsigned cs_work = 0;
+    unsigned think_work = 0;
+    int duration_ms = 1000;
+    bool csv = false;
+    const char *hist_file = nullptr;
+    bool virtual_dispatch = false;
+};
+
+inline const char *bench_options_usage() {
+    return "Options:\n"
+           "\t--threads=1,2,8  Thread counts to run (default: 1, 2, 4, ...)\n"
+           "\t--max-threads=N  Largest thread count of the default sweep\n"
+           "\t--pin=POLICY     none, compact, scatter or smt (default: none)\n"
+           "\t--cs=N           Critical section length, in loop iterations\n"
+           "\t--think=N        Think time between operations, in loop "
+           "iterations\n"
+           "\t--duration=MS    Duration of every run (default: 1000)\n"
+           "\t--csv            Print CSV instead of a table\n"
+           "\t--hist=FILE      Write the latency histograms to FILE as CSV\n"
+           "\t--virtual        Call the implementation through its virtual "
+           "base class\n";
+}
+
+/**
+ * Parses the common options. Positional arguments are moved to the end of
+ * argv, starting at index optind, where the benchmark can parse them.
+ *
+ * Returns:
+ *	false if the options are invalid.
+ */
+inline bool parse_bench_options(int argc, char *argv[], bench_options &opt) {
+    static const option long_options[] = {
+        {"threads", required_argument, nullptr, 't'},
+        {"max-threads", required_argument, nullptr, 'm'},
+        {"pin", required_argument, nullptr, 'p'},
+        {"cs", required_argument, nullptr, 'c'},
+        {"think", required_argument, nullptr, 'k'},
+        {"duration", required_argument, nullptr, 'd'},
+        {"csv", no_argument, nullptr, 'v'},
+        {"hist", required_argument, nullptr, 'h'},
+        {"virtual", no_argument, nullptr, 'V'},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    opt.max_threads =
+        std::min<int>(MAX_THREADS, std::thread::hardware_concurrency());
+
+    int c;
+    while ((c = getopt_long(argc, argv, "", long_options, nullptr)) != -1) {
+        switch (c) {
+        case 't': {
+            std::stringstream list(optarg);
+            std::string item;
+            while (std::getline(list, item, ',')) {
+                const int t = atoi(item.c_str());
+                if (t < 1 || t > MAX_THREADS) {
+                    return false;
+                }
+                opt.threads.push_back(t);
+            }
+            break;
+        }
+        case 'm':
+            opt.max_threads = atoi(optarg);
+            if (opt.max_threads < 1 || opt.max_threads > MAX_THREADS) {
+                return false;
+            }
+            break;
+        case 'p':
+            opt.pin_name = optarg;
+            if (strcmp(optarg, "none") == 0) {
+                opt.pin = pin_policy::none;
+            } else if (strcmp(optarg, "compact") == 0) {
+                opt.pin = pin_policy::compact;
+            } else if (strcmp(optarg, "scatter") == 0) {
+                opt.pin = pin_policy::scatter;
+            } else if (strcmp(optarg, "smt") == 0) {
+                opt.pin = pin_policy::smt;
+            } else {
+                return false;
+            }
+            break;
+        case 'c':
+            opt.cs_work = atoi(optarg);
+            break;
+        case 'k':
+            opt.think_work = atoi(optarg);
+            break;
+        case 'd':
+            opt.duration_ms = atoi(optarg);
+            if (opt.duration_ms <= 0) {
+                return false;
+            }
+            break;
+        case 'v':
+            opt.csv = true;
+            break;
+        case 'h':
+            opt.hist_file = optarg;
+            break;
+        case 'V':
+            opt.virtual_dispatch = true;
+            break;
+        default:
+            return false;
+        }
+    }
+
+    if (opt.threads.empty()) {
+        for (int t = 1;; t = std::min(t * 2, opt.max_threads)) {
+            opt.threads.push_back(t);
+            if (t == opt.max_threads) {
+                break;
+            }
+        }
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+ *                                CPU placement                                *
+ ******************************************************************************/
+
+struct bench_cpu {
+    int cpu;
+    int package;
+    int core;
+    // 0 for the first hardware thread of a core, 1 for its SMT sibling, ...
+    int smt;
+};
+
+inline int read_topology_value(int cpu, const char *file, int fallback) {
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/%s",
+             cpu, file);
+    std::ifstream in(path);
+    int value;
+    return in >> value ? value : fallback;
+}
+
+/**
+ * Returns the CPUs we may run on in the order in which threads are placed on
+ * them by the given policy:
+ *
+ *	compact: one hardware thread per core, filling one package before
+ *	         moving on to the next; SMT siblings last.
+ *	scatter: one hardware thread per core, alternating between packages;
+ *	         SMT siblings last.
+ *	smt:     all hardware threads of a core before moving on to the next.
+ *
+ * Empty for pin_policy::none.
+ */
+inline std::vector<int> bench_cpu_order(pin_policy policy) {
+    std::vector<int> order;
+    if (policy == pin_policy::none) {
+        return order;
+    }
+
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return order;
+    }
+
+    std::vector<bench_cpu> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &allowed)) {
+            cpus.push_back({cpu, read_topology_value(cpu, "physical_package_id", 0),
+                            read_topology_value(cpu, "core_id", cpu), 0});
+        }
+    }
+    for (auto &a : cpus) {
+        for (auto &b : cpus) {
+            if (b.cpu < a.cpu && b.package == a.package && b.core == a.core) {
+                a.smt++;
+            }
+        }
+    }
+
+    // Rank of every core within its package, used to alternate packages
+    auto core_rank = [&](const bench_cpu &c) {
+        int rank = 0;
+        for (auto &o : cpus) {
+            rank += o.smt == 0 && o.package == c.package && o.core < c.core;
+        }
+        return rank;
+    };
+
+    std::vector<std::pair<std::vector<int>, int>> keyed;
+    for (auto &c : cpus) {
+        std::vector<int> key;
+        switch (policy) {
+        case pin_policy::compact:
+            key = {c.smt, c.package, c.core};
+            break;
+        case pin_policy::scatter:
+            key = {c.smt, core_rank(c), c.package};
+            break;
+        default:
+            key = {c.package, c.core, c.smt};
+            break;
+        }
+        keyed.emplace_back(key, c.cpu);
+    }
+    std::sort(keyed.begin(), keyed.end());
+    for (auto &k : keyed) {
+        order.push_back(k.second);
+    }
+
+    return order;
+}
+
+inline void bench_pin(const std::vector<int> &order, int tid) {
+    if (order.empty()) {
+        return;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(order[tid % order.size()], &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+/*******************************************************************************
+ *                                   Driver                                    *
+ ******************************************************************************/
+
+// Busy work used for the critical section and think time knobs
+inline void bench_work(unsigned iterations) {
+    for (unsigned i = 0; i < iterations; ++i) {
+        asm volatile("" ::: "memory");
+    }
+}
+
+struct alignas(CACHE_LINE_SIZE) bench_thread_result {
+    uint64_t ops = 0;
+    latency_histogram latency;
+};
+
+struct bench_result {
+    int threads;
+    double seconds;
+    std::vector<bench_thread_result> per_thread;
+    // Latencies of all threads
+    latency_histogram latency;
+
+    uint64_t total_ops() const {
+        uint64_t ops = 0;
+        for (auto &t : per_thread) {
+            ops += t.ops;
+        }
+        return ops;
+    }
+
+    // Jain's fairness index of the per-thread throughput, 1 if all threads
+    // completed the same number of operations, 1/threads if one thread did
+    // all the work.
+    double jain_index() const {
+        double sum = 0, sum_sq = 0;
+        for (auto &t : per_thread) {
+            sum += t.ops;
+            sum_sq += double(t.ops) * t.ops;
+        }
+        return sum_sq ? sum * sum / (per_thread.size() * sum_sq) : 1.0;
+    }
+};
+
+// The driver behind bench_run() and bench_run_collective()
+template <bool Collective, typename Op>
+bench_result bench_run_threads(const bench_options &opt, int threads,
+                               const Op &op) {
+    const std::vector<int> order = bench_cpu_order(opt.pin);
+    std::vector<bench_thread_result> results(threads);
+    std::atomic<int> ready(0);
+    std::atomic<bool> stop(false);
+    // Collective: the last operation that all threads perform
+    std::atomic<uint64_t> stop_op(UINT64_MAX);
+    std::vector<std::thread> workers;
+
+    for (int tid = 0; tid < threads; ++tid) {
+        workers.emplace_back([&, tid]() {
+            bench_thread_result &result = results[tid];
+            bench_pin(order, tid);
+
+            ready.fetch_add(1);
+            while (ready.load() >= 0) {
+                std::this_thread::yield();
+            }
+
+            for (;;) {
+                // The index of this operation
+                const uint64_t i = result.ops;
+                if (!Collective && stop.load(std::memory_order_relaxed)) {
+                    break;
+                }
+                if (Collective && tid == 0 &&
+                    stop.load(std::memory_order_relaxed) &&
+                    stop_op.load(std::memory_order_relaxed) == UINT64_MAX) {
+                    stop_op.store(i, std::memory_order_relaxed);
+                }
+                const auto start = bench_clock::now();
+                op(tid);
+                const auto end = bench_clock::now();
+                result.latency.record(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(end -
+                                                                         start)
+                        .count());
+                result.ops++;
+                if (Collective &&
+                    stop_op.load(std::memory_order_relaxed) <= i) {
+                    break;
+                }
+                bench_work(opt.think_work);
+            }
+        });
+    }
+    while (ready.load() != threads) {
+        std::this_thread::yield();
+    }
+
+    const auto start_time = bench_clock::now();
+    ready.store(-1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(opt.duration_ms));
+    stop.store(true);
+    for (auto &w : workers) {
+        w.join();
+    }
+    const std::chrono::duration<double> total_time =
+        bench_clock::now() - start_time;
+
+    bench_result r;
+    r.threads = threads;
+    r.seconds = total_time.count();
+    r.per_thread = std::move(results);
+    for (auto &t : r.per_thread) {
+        r.latency.merge(t.latency);
+    }
+    return r;
+}
+
+/**
+ * Runs op(thread_id) in a loop on the given number of threads for
+ * opt.duration_ms, with opt.think_work iterations of think time between the
+ * operations. The latency of every call of op is recorded. The driver loop is
+ * instantiated for every op, so op can be inlined into it.
+ */
+template <typename Op>
+bench_result bench_run(const bench_options &opt, int threads, const Op &op) {
+    return bench_run_threads<false>(opt, threads, op);
+}
+
+/**
+ * Like bench_run(), for operations that all threads have to take part in,
+ * such as a barrier: a thread that stopped on its own would leave the others
+ * waiting for it. Every thread performs the same number of operations.
+ * Thread 0 picks the last one when the time is up and publishes it before it
+ * enters that operation, which the others leave only after thread 0 has
+ * entered it, so they see the choice in time.
+ */
+template <typename Op>
+bench_result bench_run_collective(const bench_options &opt, int threads,
+                                  const Op &op) {
+    return bench_run_threads<true>(opt, threads, op);
+}
+
+/**
+ * Prints the results of the runs of a benchmark, as a table or as CSV. The
+ * benchmark may add columns of its own.
+ */
+class bench_reporter {
+public:
+    bench_reporter(const bench_options &opt, const std::string &name,
+                   std::vector<std::string> extra_columns = {})
+        : m_opt(opt)
+        , m_name(name)
+        , m_extra_columns(std::move(extra_columns)) {
+        if (opt.hist_file) {
+            m_hist.open(opt.hist_file);
+            m_hist << "name,threads,bucket_ns,count\n";
+        }
+    }
+
+    void report(const bench_result &r,
+                const std::vector<std::string> &extra_values = {}) {
+        const uint64_t ops = r.total_ops();
+        uint64_t min_ops = UINT64_MAX, max_ops = 0;
+        for (auto &t : r.per_thread) {
+            min_ops = std::min(min_ops, t.ops);
+            max_ops = std::max(max_ops, t.ops);
+        }
+        const std::vector<std::string> values = {
+            std::to_string(r.threads),
+            std::to_string(uint64_t(ops / r.seconds)),
+            format_double(r.jain_index()),
+            std::to_string(uint64_t(min_ops / r.seconds)),
+            std::to_string(uint64_t(max_ops / r.seconds)),
+            std::to_string(r.latency.percentile(0.5)),
+            std::to_string(r.latency.percentile(0.9)),
+            std::to_string(r.latency.percentile(0.99)),
+            std::to_string(r.latency.percentile(0.999)),
+            std::to_string(r.latency.max()),
+        };
+
+        if (!m_header_done) {
+            print_header();
+            m_header_done = true;
+        }
+        if (m_opt.csv) {
+            std::cout << m_name << "," << m_opt.pin_name << "," << m_opt.cs_work
+                      << "," << m_opt.think_work;
+            for (auto &v : values) {
+                std::cout << "," << v;
+            }
+            for (auto &v : extra_values) {
+                std::cout << "," << v;
+            }
+        } else {
+            for (auto &v : values) {
+                std::cout << std::setw(12) << v;
+            }
+            for (auto &v : extra_values) {
+                std::cout << std::setw(12) << v;
+            }
+        }
+        std::cout << std::endl;
+
+        if (m_hist.is_open()) {
+            for (int b = 0; b < latency_histogram::no_buckets; ++b) {
+                if (r.latency.count(b)) {
+                    m_hist << m_name << "," << r.threads << ","
+                           << latency_histogram::lowest(b) << ","
+                           << r.latency.count(b) << "\n";
+                }
+            }
+        }
+    }
+
+private:
+    static std::string format_double(double v) {
+        std::ostringstream s;
+        s << std::fixed << std::setprecision(3) << v;
+        return s.str();
+    }
+
+    void print_header() {
+        static const char *columns[] = {
+            "threads", "ops/s",  "jain",   "min_thr/s", "max_thr/s",
+            "p50_ns",  "p90_ns", "p99_ns", "p999_ns",   "max_ns",
+        };
+        if (m_opt.csv) {
+            std::cout << "name,pin,cs,think";
+            for (auto c : columns) {
+                std::cout << "," << c;
+            }
+            for (auto &c : m_extra_columns) {
+                std::cout << "," << c;
+            }
+        } else {
+            std::cout << m_name << ", pin: " << m_opt.pin_name
+                      << ", cs: " << m_opt.cs_work
+                      << ", think: " << m_opt.think_work
+                      << " (latencies of whole operations in ns)\n";
+            for (auto c : columns) {
+                std::cout << std::setw(12) << c;
+            }
+            for (auto &c : m_extra_columns) {
+                std::cout << std::setw(12) << c;
+            }
+        }
+        std::cout << "\n";
+    }
+
+    const bench_options &m_opt;
+    std::string m_name;
+    std::vector<std::string> m_extra_columns;
+    std::ofstream m_hist;
+    bool m_header_done = false;
+};
+
+#endif // BENCH_COMMON_HPP
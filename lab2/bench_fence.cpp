@@ -0,0 +1,156 @@
+#include "bench_common.hpp"
+
+// Cost of the memory ordering primitives used by the locks. Every thread runs
+// the primitive on atomics of its own, so there is no contention and the
+// results show the cost of the instructions themselves. The RMW-free locks
+// (dekker, filter, bakery) pay for a store->load fence ("fence") where the
+// other locks pay for a read-modify-write ("exchange", "fetch_add", "cas").
+// Compare with bench_user_lock --threads=1 for the cost of a whole
+// lock/unlock pair.
+
+// The primitives a benchmark can select, see primitive_names
+enum class primitive {
+    relaxed,
+    release_acquire,
+    fence,
+    seq_cst,
+    exchange,
+    fetch_add,
+    cas,
+};
+
+static const struct {
+    const char *name;
+    const char *description;
+} primitive_names[] = {
+    {"relaxed", "relaxed store and load (no ordering)"},
+    {"release_acquire", "release store and acquire load"},
+    {"fence", "relaxed store, seq_cst fence, relaxed load"},
+    {"seq_cst", "seq_cst store and seq_cst load"},
+    {"exchange", "acq_rel exchange (test-and-set, CLH, MCS)"},
+    {"fetch_add", "acq_rel fetch_add (ticket lock)"},
+    {"cas", "acq_rel compare_exchange_strong (successful)"},
+};
+
+// Number of primitives per timed operation, amortizes the clock reads
+static const int batch = 100;
+
+struct alignas(CACHE_LINE_SIZE) thread_vars {
+    std::atomic<uint64_t> a;
+    std::atomic<uint64_t> b;
+    uint64_t sink;
+};
+
+template <primitive P>
+void run_batch(thread_vars &v) {
+    uint64_t sum = 0;
+    for (int i = 0; i < batch; ++i) {
+        if constexpr (P == primitive::relaxed) {
+            v.a.store(i, std::memory_order_relaxed);
+            sum += v.b.load(std::memory_order_relaxed);
+        } else if constexpr (P == primitive::release_acquire) {
+            v.a.store(i, std::memory_order_release);
+            sum += v.b.load(std::memory_order_acquire);
+        } else if constexpr (P == primitive::fence) {
+            v.a.store(i, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            sum += v.b.load(std::memory_order_relaxed);
+        } else if constexpr (P == primitive::seq_cst) {
+            v.a.store(i, std::memory_order_seq_cst);
+            sum += v.b.load(std::memory_order_seq_cst);
+        } else if constexpr (P == primitive::exchange) {
+            sum += v.a.exchange(i, std::memory_order_acq_rel);
+        } else if constexpr (P == primitive::fetch_add) {
+            sum += v.a.fetch_add(1, std::memory_order_acq_rel);
+        } else if constexpr (P == primitive::cas) {
+            uint64_t expected = v.a.load(std::memory_order_relaxed);
+            v.a.compare_exchange_strong(expected, expected + 1,
+                                        std::memory_order_acq_rel);
+            sum += expected;
+        }
+    }
+    v.sink += sum;
+}
+
+template <primitive P>
+bench_result run_primitive(const bench_options &opt, int threads) {
+    std::vector<thread_vars> vars(threads);
+    for (auto &v : vars) {
+        v.a.store(0);
+        v.b.store(0);
+        v.sink = 0;
+    }
+    return bench_run(opt, threads, [&](int tid) { run_batch<P>(vars[tid]); });
+}
+
+void usage(char *argv[]) {
+    std::cerr << "Usage: " << argv[0] << " [OPTIONS] <PRIMITIVE>\n\n"
+              << "Where <PRIMITIVE> can be:\n";
+    for (auto &p : primitive_names) {
+        std::cerr << "\t" << std::left << std::setw(16) << p.name
+                  << p.description << "\n";
+    }
+    std::cerr << "\n" << bench_options_usage();
+}
+
+int main(int argc, char *argv[]) {
+    bench_options opt;
+    if (!parse_bench_options(argc, argv, opt) || optind != argc - 1) {
+        usage(argv);
+        return -1;
+    }
+    const char *name = argv[optind];
+
+    int index = -1;
+    for (size_t i = 0; i < sizeof(primitive_names) / sizeof(*primitive_names);
+         ++i) {
+        if (strcmp(name, primitive_names[i].name) == 0) {
+            index = i;
+        }
+    }
+    if (index < 0) {
+        usage(argv);
+        return -1;
+    }
+
+    // The latencies reported by the driver are per batch
+    bench_reporter reporter(opt, name, {"ns/primitive"});
+    for (int threads : opt.threads) {
+        bench_result r;
+        switch (primitive(index)) {
+        case primitive::relaxed:
+            r = run_primitive<primitive::relaxed>(opt, threads);
+            break;
+        case primitive::release_acquire:
+            r = run_primitive<primitive::release_acquire>(opt, threads);
+            break;
+        case primitive::fence:
+            r = run_primitive<primitive::fence>(opt, threads);
+            break;
+        case primitive::seq_cst:
+            r = run_primitive<primitive::seq_cst>(opt, threads);
+            break;
+        case primitive::exchange:
+            r = run_primitive<primitive::exchange>(opt, threads);
+            break;
+        case primitive::fetch_add:
+            r = run_primitive<primitive::fetch_add>(opt, threads);
+            break;
+        case primitive::cas:
+            r = run_primitive<primitive::cas>(opt, threads);
+            break;
+        }
+
+        // Time spent per primitive by one thread, includes the clock reads
+        // of the driver amortized over the batch
+        const double ns = r.total_ops()
+                              ? 1e9 * r.seconds * threads /
+                                    (double(r.total_ops()) * batch)
+                              : 0;
+        std::ostringstream value;
+        value << std::fixed << std::setprecision(2) << ns;
+        reporter.report(r, {value.str()});
+    }
+
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include "bench_common.hpp"
+#include "lockfree.hpp"
+
+// Churn benchmark for the memory reclamation schemes. Every operation puts a
+// value into the structure and takes one out again, which allocates one node
+// and retires one. Compare the throughput of the reclaimers to see their
+// overhead. The memory footprint is the number of retired nodes that have not
+// been freed yet, thread 0 samples it every sample_interval operations. We
+// report the peak, in nodes and in KiB of node memory.
+
+// Operations of thread 0 between two footprint samples
+static const int sample_interval = 64;
+
+void usage(char *argv[]) {
+    std::cerr << "Usage: " << argv[0]
+              << " [OPTIONS] <STRUCTURE> <RECLAIMER> [PREFILL]\n\n"
+              << "Where <STRUCTURE> can be:\n";
+    for (const char *const *name = lockfree_names; *name; ++name) {
+        std::cerr << "\t" << *name << "\n";
+    }
+    std::cerr << "\n<RECLAIMER> can be:\n";
+    for (const char *const *name = reclaimer_names; *name; ++name) {
+        std::cerr << "\t" << *name << "\n";
+    }
+    std::cerr << "\nAnd [PREFILL] is the number of values in the structure "
+                 "at the start (default:\n1000).\n\n"
+              << bench_options_usage();
+}
+
+int main(int argc, char *argv[]) {
+    bench_options opt;
+    if (!parse_bench_options(argc, argv, opt) || argc - optind < 2 ||
+        argc - optind > 3) {
+        usage(argv);
+        return -1;
+    }
+    const char *structure = argv[optind];
+    const char *reclaimer = argv[optind + 1];
+    const int prefill = argc - optind > 2 ? atoi(argv[optind + 2]) : 1000;
+    if (opt.virtual_dispatch) {
+        std::cerr << "--virtual is not supported, the reclaimers are only "
+                     "available as template\nparameters\n";
+        return -1;
+    }
+
+    bench_reporter reporter(opt, std::string(structure) + "/" + reclaimer,
+                            {"pending_max", "pending_kb", "pending_end"});
+    for (int threads : opt.threads) {
+        const bool found =
+            lockfree_visit(structure, reclaimer, threads, [&](auto &s) {
+                for (int i = 0; i < prefill; ++i) {
+                    put(s, 0, i);
+                }
+
+                uint64_t pending_max = 0;
+                unsigned until_sample = 0;
+                bench_result r = bench_run(opt, threads, [&](int tid) {
+                    uint64_t v = tid;
+                    put(s, tid, v);
+                    take(s, tid, v);
+                    if (tid == 0 && until_sample-- == 0) {
+                        until_sample = sample_interval;
+                        pending_max =
+                            std::max(pending_max, s.reclaimer().pending());
+                    }
+                });
+
+                using structure_type = std::remove_reference_t<decltype(s)>;
+                reporter.report(
+                    r, {std::to_string(pending_max),
+                        std::to_string(pending_max * structure_type::node_size /
+                                       1024),
+                        std::to_string(s.reclaimer().pending())});
+            });
+        if (!found) {
+            std::cerr << "Invalid <STRUCTURE> " << structure
+                      << " or <RECLAIMER> " << reclaimer << "\n";
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,152 @@
+#include "bench_common.hpp"
+#include "seqlock.hpp"
+
+// Reader scalability of seqlock reads compared to reading under a lock. Every
+// operation reads or writes a shared struct, chosen at random with the given
+// share of reads. In the seqlock mode writers take <LOCK> through the seqlock
+// and readers read optimistically; in the locked mode readers take <LOCK> as
+// well, e.g. "locked mutex" is the user_lock_mutex baseline. In addition to
+// the common results we report the writes and the average number of retries
+// per seqlock read.
+
+// Number of words of the shared struct
+static const int data_words = 8;
+
+struct shared_data {
+    uint64_t words[data_words];
+};
+
+struct alignas(CACHE_LINE_SIZE) thread_state {
+    // xorshift32 state
+    uint32_t rng;
+    uint64_t reads = 0;
+    uint64_t writes = 0;
+    uint64_t retries = 0;
+    uint64_t torn = 0;
+};
+
+void usage(char *argv[]) {
+    std::cerr << "Usage: " << argv[0]
+              << " [OPTIONS] <MODE> <LOCK> [READ_PCT]\n\n"
+              << "<MODE> is seqlock or locked, READ_PCT is the percentage of "
+                 "reads (default: 99).\nWhere <LOCK> can be:\n";
+    for (const user_lock_info *info = user_lock_registry; info->name; ++info) {
+        std::cerr << "\t" << info->name << "\n";
+    }
+    std::cerr << "\n" << bench_options_usage();
+}
+
+int main(int argc, char *argv[]) {
+    bench_options opt;
+    if (!parse_bench_options(argc, argv, opt) || argc - optind < 2 ||
+        argc - optind > 3) {
+        usage(argv);
+        return -1;
+    }
+    const char *mode = argv[optind];
+    const char *name = argv[optind + 1];
+    const int read_pct = argc - optind > 2 ? atoi(argv[optind + 2]) : 99;
+    const bool optimistic = strcmp(mode, "seqlock") == 0;
+    if ((!optimistic && strcmp(mode, "locked") != 0) || read_pct < 0 ||
+        read_pct > 100) {
+        usage(argv);
+        return -1;
+    }
+
+    bench_reporter reporter(opt,
+                            std::string(mode) + " " + name + " " +
+                                std::to_string(read_pct) + "% reads",
+                            {"writes/s", "retry/read"});
+    for (int threads : opt.threads) {
+        bool ok = true;
+        // Instantiated for every lock type, and for user_lock with --virtual
+        auto run = [&](auto &lock) {
+            seqlock<std::remove_reference_t<decltype(lock)>> sl(lock);
+            seqlock_data<shared_data> data;
+            std::vector<thread_state> state(threads);
+            for (int tid = 0; tid < threads; ++tid) {
+                state[tid].rng = 2463534242u + tid * 2654435761u;
+            }
+
+            bench_result r = bench_run(opt, threads, [&](int tid) {
+                thread_state &s = state[tid];
+                s.rng ^= s.rng << 13;
+                s.rng ^= s.rng >> 17;
+                s.rng ^= s.rng << 5;
+                shared_data d;
+                if (s.rng % 100 < unsigned(read_pct)) {
+                    if (optimistic) {
+                        for (;;) {
+                            const unsigned seq = sl.read_begin();
+                            d = data.load();
+                            bench_work(opt.cs_work);
+                            if (!sl.read_retry(seq)) {
+                                break;
+                            }
+                            s.retries++;
+                        }
+                    } else {
+                        lock.lock(tid);
+                        d = data.load();
+                        bench_work(opt.cs_work);
+                        lock.unlock(tid);
+                    }
+                    for (int i = 1; i < data_words; ++i) {
+                        s.torn += d.words[i] != d.words[0];
+                    }
+                    s.reads++;
+                } else {
+                    sl.write_lock(tid);
+                    d = data.load();
+                    for (int i = 0; i < data_words; ++i) {
+                        d.words[i]++;
+                    }
+                    data.store(d);
+                    bench_work(opt.cs_work);
+                    sl.write_unlock(tid);
+                    s.writes++;
+                }
+            });
+
+            uint64_t reads = 0, writes = 0, retries = 0, torn = 0;
+            for (auto &s : state) {
+                reads += s.reads;
+                writes += s.writes;
+                retries += s.retries;
+                torn += s.torn;
+            }
+            if (data.load().words[0] != writes || torn) {
+                std::cerr << "Inconsistent data: " << writes << " writes, "
+                          << "counter is " << data.load().words[0] << ", "
+                          << torn << " torn reads\n";
+                ok = false;
+                return;
+            }
+
+            std::ostringstream retries_per_read;
+            retries_per_read << std::fixed << std::setprecision(3)
+                             << (reads ? double(retries) / reads : 0.0);
+            reporter.report(r, {std::to_string(uint64_t(writes / r.seconds)),
+                                retries_per_read.str()});
+        };
+
+        bool found;
+        if (opt.virtual_dispatch) {
+            std::unique_ptr<user_lock> lock(user_lock_create(name, threads));
+            if ((found = lock != nullptr)) {
+                run(*lock);
+            }
+        } else {
+            found = user_lock_visit(name, threads, run);
+        }
+        if (!found) {
+            std::cerr << "Invalid <LOCK> " << name << " for " << threads
+                      << " threads\n";
+        }
+        if (!ok) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,55 @@
+#!/bin/bash
+#
+# Measure the cache-line traffic caused by the different locks using perf
+# stat. The default events are generic; on a two-socket machine, set EVENTS
+# to the cross-socket events of the CPU, e.g. on recent Intel parts:
+#
+#   EVENTS=mem_load_l3_miss_retired.remote_hitm,mem_load_l3_miss_retired.remote_fwd ./bench_traffic.sh
+#
+# Usage: [LOCKS="..."] [THREADS="..."] [ITERATIONS=N] [EVENTS="..."] ./bench_traffic.sh
+#
+# THREADS defaults to the powers of two from 2 up to the number of cores, as a
+# spinning lock with more threads than cores mostly measures the scheduler.
+#
+# Prints one CSV line per lock, thread count and event:
+#   lock,threads,event,count
+#
+
+SCRIPT_DIR=$( cd -- "$( dirname -- "${BASH_SOURCE[0]}" )" &> /dev/null && pwd )
+
+LOCKS=${LOCKS:-"mutex clh_n mcs k42"}
+if [ -z "${THREADS}" ]; then
+    CORES=$(nproc)
+    for (( n = 2; n <= CORES && n <= 64; n *= 2 )); do
+        THREADS="${THREADS} ${n}"
+    done
+    if [ -z "${THREADS}" ]; then
+        echo "Need at least 2 cores, set THREADS to run anyway." 1>&2
+        exit 1
+    fi
+fi
+ITERATIONS=${ITERATIONS:-2000000}
+EVENTS=${EVENTS:-"cache-misses,LLC-load-misses,LLC-store-misses"}
+
+TEST="${SCRIPT_DIR}/test_user_lock"
+
+if [ ! -x "${TEST}" ]; then
+    echo "Can't find ${TEST}, run make first." 1>&2
+    exit 1
+fi
+
+if ! command -v perf > /dev/null; then
+    echo "Can't find perf." 1>&2
+    exit 1
+fi
+
+echo "lock,threads,event,count"
+for lock in ${LOCKS}; do
+    for threads in ${THREADS}; do
+        perf stat -x, -e "${EVENTS}" "${TEST}" "${lock}" "${threads}" \
+             "${ITERATIONS}" \
+             2>&1 > /dev/null | \
+            awk -F, -v lock="${lock}" -v threads="${threads}" \
+                'NF > 2 { print lock "," threads "," $3 "," $1 }'
+    done
+done
@@ -0,0 +1,58 @@
+#include "bench_common.hpp"
+#include "user_barriers.hpp"
+
+// Barrier latency sweep. Every operation is one barrier episode, which all
+// threads take part in, so the latency histogram is the time from a thread's
+// arrival to its release and ns/episode is the wall time between episodes.
+// --think adds work between the episodes, --cs is unused.
+
+void usage(char *argv[]) {
+    std::cerr << "Usage: " << argv[0] << " [OPTIONS] <BARRIER>\n\n"
+              << "Where <BARRIER> can be:\n";
+    for (const user_barrier_info *info = user_barrier_registry; info->name;
+         ++info) {
+        std::cerr << "\t" << info->name << "\n";
+    }
+    std::cerr << "\n" << bench_options_usage();
+}
+
+int main(int argc, char *argv[]) {
+    bench_options opt;
+    if (!parse_bench_options(argc, argv, opt) || optind != argc - 1) {
+        usage(argv);
+        return -1;
+    }
+    const char *name = argv[optind];
+
+    bench_reporter reporter(opt, name, {"ns/episode"});
+    for (int threads : opt.threads) {
+        // Instantiated for every barrier type, and for user_barrier with
+        // --virtual
+        auto run = [&](auto &barrier) {
+            bench_result r = bench_run_collective(
+                opt, threads, [&](int tid) { barrier.wait(tid); });
+
+            // Every thread has taken part in every episode
+            const uint64_t episodes = r.per_thread[0].ops;
+            reporter.report(
+                r, {std::to_string(uint64_t(r.seconds * 1e9 / episodes))});
+        };
+
+        bool found;
+        if (opt.virtual_dispatch) {
+            std::unique_ptr<user_barrier> barrier(
+                user_barrier_create(name, threads));
+            if ((found = barrier != nullptr)) {
+                run(*barrier);
+            }
+        } else {
+            found = user_barrier_visit(name, threads, run);
+        }
+        if (!found) {
+            std::cerr << "Invalid <BARRIER> " << name << "\n";
+            return 1;
+        }
+    }
+
+    return 0;
+}
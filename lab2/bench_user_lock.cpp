@@ -0,0 +1,120 @@
+#include "bench_common.hpp"
+#include "user_locks.hpp"
+
+// Contention sweep for the user locks. Every operation acquires the lock, runs
+// the critical section and releases the lock. In addition to the common
+// results we report the handoff time: the time from a thread starting to
+// release the lock until another thread returns from lock(), and the handoff
+// locality: the share of handoffs that stay on the NUMA node of the previous
+// lock holder (see thread_numa_node()).
+
+// State protected by the lock
+struct alignas(CACHE_LINE_SIZE) protected_state {
+    uint64_t counter;
+    // The thread that held the lock last, -1 if none, and its NUMA node
+    int owner;
+    int owner_node;
+    // The time the last lock holder started to release the lock
+    bench_clock::time_point released;
+};
+
+void usage(char *argv[]) {
+    std::cerr << "Usage: " << argv[0] << " [OPTIONS] <LOCK>\n\n"
+              << "Where <LOCK> can be:\n";
+    for (const user_lock_info *info = user_lock_registry; info->name; ++info) {
+        std::cerr << "\t" << info->name << "\n";
+    }
+    std::cerr << "\n" << bench_options_usage();
+}
+
+int main(int argc, char *argv[]) {
+    bench_options opt;
+    if (!parse_bench_options(argc, argv, opt) || optind != argc - 1) {
+        usage(argv);
+        return -1;
+    }
+    const char *name = argv[optind];
+
+    bench_reporter reporter(opt, name,
+                            {"hoff_p50_ns", "hoff_p99_ns", "hoff_local%"});
+    for (int threads : opt.threads) {
+        bool ok = true;
+        // Instantiated for every lock type, and for user_lock with --virtual
+        auto run = [&](auto &lock) {
+            protected_state state;
+            state.counter = 0;
+            state.owner = -1;
+            state.owner_node = -1;
+            std::vector<padded<latency_histogram>> handoff(threads);
+            std::vector<padded<uint64_t>> local_handoffs(threads);
+
+            // Cache the node of every thread, looking it up inside the
+            // critical section would make it longer
+            std::vector<padded<int>> node(threads);
+            for (auto &n : node) {
+                n.value = -1;
+            }
+
+            bench_result r = bench_run(opt, threads, [&](int tid) {
+                if (node[tid].value < 0) {
+                    node[tid].value = thread_numa_node(tid);
+                }
+                lock.lock(tid);
+                const auto acquired = bench_clock::now();
+
+                state.counter++;
+                if (state.owner >= 0 && state.owner != tid) {
+                    handoff[tid].value.record(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            acquired - state.released)
+                            .count());
+                    local_handoffs[tid].value +=
+                        state.owner_node == node[tid].value;
+                }
+                bench_work(opt.cs_work);
+                state.owner = tid;
+                state.owner_node = node[tid].value;
+                state.released = bench_clock::now();
+                lock.unlock(tid);
+            });
+
+            if (r.total_ops() != state.counter) {
+                std::cerr << "Mutual exclusion violated: " << r.total_ops()
+                          << " ops but counter is " << state.counter << "\n";
+                ok = false;
+                return;
+            }
+
+            latency_histogram all_handoffs;
+            uint64_t local = 0;
+            for (int tid = 0; tid < threads; ++tid) {
+                all_handoffs.merge(handoff[tid].value);
+                local += local_handoffs[tid].value;
+            }
+            const uint64_t handoffs = all_handoffs.total();
+            reporter.report(
+                r, {std::to_string(all_handoffs.percentile(0.5)),
+                    std::to_string(all_handoffs.percentile(0.99)),
+                    std::to_string(handoffs ? 100 * local / handoffs : 100)});
+        };
+
+        bool found;
+        if (opt.virtual_dispatch) {
+            std::unique_ptr<user_lock> lock(user_lock_create(name, threads));
+            if ((found = lock != nullptr)) {
+                run(*lock);
+            }
+        } else {
+            found = user_lock_visit(name, threads, run);
+        }
+        if (!found) {
+            std::cerr << "Invalid <LOCK> " << name << " for " << threads
+                      << " threads\n";
+        }
+        if (!ok) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
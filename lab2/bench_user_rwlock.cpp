@@ -0,0 +1,113 @@
+#include "bench_common.hpp"
+#include "user_rwlocks.hpp"
+
+// Throughput sweep for the reader-writer locks. Every operation is a read or
+// a write critical section, chosen at random with the given share of reads.
+
+// Number of words read/written in every critical section
+static const int data_words = 8;
+
+struct alignas(CACHE_LINE_SIZE) thread_state {
+    // xorshift32 state
+    uint32_t rng;
+    uint64_t writes = 0;
+    uint64_t sum = 0;
+};
+
+void usage(char *argv[]) {
+    std::cerr << "Usage: " << argv[0] << " [OPTIONS] <LOCK> [READ_PCT]\n\n"
+              << "READ_PCT is the percentage of reads (default: 95). Where "
+                 "<LOCK> can be:\n";
+    for (const user_rwlock_info *info = user_rwlock_registry; info->name;
+         ++info) {
+        std::cerr << "\t" << info->name << "\n";
+    }
+    std::cerr << "\n" << bench_options_usage();
+}
+
+int main(int argc, char *argv[]) {
+    bench_options opt;
+    if (!parse_bench_options(argc, argv, opt) || optind < argc - 2 ||
+        optind > argc - 1) {
+        usage(argv);
+        return -1;
+    }
+    const char *name = argv[optind];
+    const int read_pct = optind == argc - 2 ? atoi(argv[optind + 1]) : 95;
+    if (read_pct < 0 || read_pct > 100) {
+        usage(argv);
+        return -1;
+    }
+
+    bench_reporter reporter(opt,
+                            std::string(name) + " " +
+                                std::to_string(read_pct) + "% reads",
+                            {"writes/s"});
+    for (int threads : opt.threads) {
+        bool ok = true;
+        // Instantiated for every lock type, and for user_rwlock with
+        // --virtual
+        auto run = [&](auto &lock) {
+            alignas(CACHE_LINE_SIZE) uint64_t data[data_words] = {};
+            std::vector<thread_state> state(threads);
+            for (int tid = 0; tid < threads; ++tid) {
+                state[tid].rng = 2463534242u + tid * 2654435761u;
+            }
+
+            bench_result r = bench_run(opt, threads, [&](int tid) {
+                thread_state &s = state[tid];
+                s.rng ^= s.rng << 13;
+                s.rng ^= s.rng >> 17;
+                s.rng ^= s.rng << 5;
+                if (s.rng % 100 < unsigned(read_pct)) {
+                    lock.lock_shared(tid);
+                    for (int i = 0; i < data_words; ++i) {
+                        s.sum += data[i];
+                    }
+                    bench_work(opt.cs_work);
+                    lock.unlock_shared(tid);
+                } else {
+                    lock.lock(tid);
+                    for (int i = 0; i < data_words; ++i) {
+                        data[i]++;
+                    }
+                    bench_work(opt.cs_work);
+                    lock.unlock(tid);
+                    s.writes++;
+                }
+            });
+
+            uint64_t writes = 0;
+            for (auto &s : state) {
+                writes += s.writes;
+            }
+            if (data[0] != writes) {
+                std::cerr << "Mutual exclusion violated: " << writes
+                          << " writes but counter is " << data[0] << "\n";
+                ok = false;
+                return;
+            }
+
+            reporter.report(r, {std::to_string(uint64_t(writes / r.seconds))});
+        };
+
+        bool found;
+        if (opt.virtual_dispatch) {
+            std::unique_ptr<user_rwlock> lock(user_rwlock_create(name, threads));
+            if ((found = lock != nullptr)) {
+                run(*lock);
+            }
+        } else {
+            found = user_rwlock_visit(name, threads, run);
+        }
+        if (!found) {
+            std::cerr << "Invalid <LOCK> " << name << " for " << threads
+                      << " threads\n";
+        }
+        if (!ok) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
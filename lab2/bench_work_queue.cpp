@@ -0,0 +1,135 @@
+#include "bench_common.hpp"
+#include "work_queues.hpp"
+
+// Producer/consumer sweep for the work queues. The first PRODUCERS threads
+// enqueue and the other CONSUMERS threads dequeue, every operation is one
+// attempt to enqueue or dequeue a batch of BATCH items, which fails if the
+// queue is full or empty. The sweep runs every combination of the producer
+// and consumer counts. The common results count attempts, in addition we
+// report the number of items that made it through the queue and the share of
+// failed attempts. The queues have work_queue_default_capacity slots.
+
+void usage(char *argv[]) {
+    std::cerr << "Usage: " << argv[0]
+              << " [OPTIONS] <QUEUE> [PRODUCERS] [CONSUMERS] [BATCH]\n\n"
+              << "Where <QUEUE> can be:\n";
+    for (const work_queue_info *info = work_queue_registry; info->name;
+         ++info) {
+        std::cerr << "\t" << info->name << "\n";
+    }
+    std::cerr << "\n[PRODUCERS] and [CONSUMERS] are lists of thread counts, "
+                 "e.g. 1,2,4 (default:\nthe --threads sweep), and [BATCH] is "
+                 "the number of items per operation\n(default: 1, which uses "
+                 "try_enqueue() and try_dequeue()).\n\n"
+              << bench_options_usage();
+}
+
+static bool parse_list(const char *arg, std::vector<int> &list) {
+    std::stringstream in(arg);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        const int n = atoi(item.c_str());
+        if (n < 1 || n >= MAX_THREADS) {
+            return false;
+        }
+        list.push_back(n);
+    }
+    return !list.empty();
+}
+
+// Largest supported BATCH
+static const int max_batch = 64;
+
+struct alignas(CACHE_LINE_SIZE) queue_thread_stats {
+    uint64_t items = 0;
+    uint64_t failed = 0;
+};
+
+int main(int argc, char *argv[]) {
+    bench_options opt;
+    if (!parse_bench_options(argc, argv, opt) || optind >= argc ||
+        argc - optind > 4) {
+        usage(argv);
+        return -1;
+    }
+    const char *name = argv[optind];
+    std::vector<int> producer_counts, consumer_counts;
+    if ((argc - optind > 1 && !parse_list(argv[optind + 1], producer_counts)) ||
+        (argc - optind > 2 && !parse_list(argv[optind + 2], consumer_counts))) {
+        usage(argv);
+        return -1;
+    }
+    if (producer_counts.empty()) {
+        producer_counts = opt.threads;
+    }
+    if (consumer_counts.empty()) {
+        consumer_counts = opt.threads;
+    }
+    const int batch = argc - optind > 3 ? atoi(argv[optind + 3]) : 1;
+    if (batch < 1 || batch > max_batch) {
+        usage(argv);
+        return -1;
+    }
+
+    bench_reporter reporter(opt, name,
+                            {"producers", "consumers", "items/s", "failed%"});
+    for (int producers : producer_counts) {
+        for (int consumers : consumer_counts) {
+            const int threads = producers + consumers;
+            if (threads > MAX_THREADS) {
+                continue;
+            }
+
+            // Instantiated for every queue type, and for work_queue with
+            // --virtual
+            auto run = [&](auto &queue) {
+                std::vector<queue_thread_stats> stats(threads);
+
+                bench_result r = bench_run(opt, threads, [&](int tid) {
+                    uint64_t items[max_batch];
+                    size_t n;
+                    if (tid < producers) {
+                        for (int i = 0; i < batch; ++i) {
+                            items[i] = tid;
+                        }
+                        n = batch == 1 ? queue.try_enqueue(items[0])
+                                       : queue.try_enqueue_batch(items, batch);
+                    } else {
+                        n = batch == 1 ? queue.try_dequeue(items[0])
+                                       : queue.try_dequeue_batch(items, batch);
+                        stats[tid].items += n;
+                    }
+                    stats[tid].failed += n == 0;
+                });
+
+                uint64_t items = 0, failed = 0;
+                for (auto &s : stats) {
+                    items += s.items;
+                    failed += s.failed;
+                }
+                const uint64_t attempts = r.total_ops();
+                reporter.report(
+                    r, {std::to_string(producers), std::to_string(consumers),
+                        std::to_string(uint64_t(items / r.seconds)),
+                        std::to_string(attempts ? 100 * failed / attempts : 0)});
+            };
+
+            bool found;
+            if (opt.virtual_dispatch) {
+                std::unique_ptr<work_queue> queue(
+                    work_queue_create(name, work_queue_default_capacity));
+                if ((found = queue != nullptr)) {
+                    run(*queue);
+                }
+            } else {
+                found = work_queue_visit(name, work_queue_default_capacity, run);
+            }
+            if (!found) {
+                std::cerr << "Invalid <QUEUE> " << name << "\n";
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,123 @@
+#ifndef LATENCY_HISTOGRAM_HPP
+#define LATENCY_HISTOGRAM_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+
+/*******************************************************************************
+ *                              Latency histogram                              *
+ ******************************************************************************/
+
+// Log-linear histogram of latencies in ns: every power of two range is split
+// into sub_buckets buckets, which bounds the relative error of a bucket to
+// 1/sub_buckets.
+class latency_histogram {
+public:
+    static const int sub_bits = 3;
+    static const int sub_buckets = 1 << sub_bits;
+    static const int no_buckets = (64 - sub_bits + 1) * sub_buckets;
+
+    void record(uint64_t ns) {
+        m_counts[bucket(ns)]++;
+        m_total++;
+        m_max = std::max(m_max, ns);
+    }
+
+    void merge(const latency_histogram &other) {
+        for (int i = 0; i < no_buckets; ++i) {
+            m_counts[i] += other.m_counts[i];
+        }
+        m_total += other.m_total;
+        m_max = std::max(m_max, other.m_max);
+    }
+
+    // The lowest latency of the bucket that contains the p:th quantile
+    uint64_t percentile(double p) const {
+        if (!m_total) {
+            return 0;
+        }
+        const uint64_t rank = std::min(m_total - 1, uint64_t(p * m_total));
+        uint64_t seen = 0;
+        for (int i = 0; i < no_buckets; ++i) {
+            seen += m_counts[i];
+            if (seen > rank) {
+                return lowest(i);
+            }
+        }
+        return m_max;
+    }
+
+    uint64_t max() const {
+        return m_max;
+    }
+
+    uint64_t total() const {
+        return m_total;
+    }
+
+    uint64_t count(int bucket) const {
+        return m_counts[bucket];
+    }
+
+    // Writes the cumulative distribution in the text format of HdrHistogram's
+    // outputPercentileDistribution(), one line per non-empty bucket, which
+    // its plotting tools read. Values are divided by scale, e.g. 1000 for us.
+    void write_percentiles(std::ostream &out, double scale = 1) const {
+        char line[96];
+        std::snprintf(line, sizeof(line), "%12s %14s %10s %14s\n\n", "Value",
+                      "Percentile", "TotalCount", "1/(1-Percentile)");
+        out << line;
+        uint64_t seen = 0;
+        for (int i = 0; i < no_buckets; ++i) {
+            if (!m_counts[i]) {
+                continue;
+            }
+            seen += m_counts[i];
+            const double p = double(seen) / m_total;
+            if (seen < m_total) {
+                std::snprintf(line, sizeof(line),
+                              "%12.3f %2.12f %10llu %14.2f\n", lowest(i) / scale,
+                              p, (unsigned long long)seen, 1 / (1 - p));
+            } else {
+                std::snprintf(line, sizeof(line), "%12.3f %2.12f %10llu\n",
+                              m_max / scale, p, (unsigned long long)seen);
+            }
+            out << line;
+        }
+        std::snprintf(line, sizeof(line),
+                      "#[Max     = %12.3f, Total count    = %12llu]\n",
+                      m_max / scale, (unsigned long long)m_total);
+        out << line;
+        std::snprintf(line, sizeof(line),
+                      "#[Buckets = %12d, SubBuckets     = %12d]\n", no_buckets,
+                      sub_buckets);
+        out << line;
+    }
+
+    static int bucket(uint64_t ns) {
+        if (ns < sub_buckets) {
+            return ns;
+        }
+        const int msb = 63 - __builtin_clzll(ns);
+        const int sub = (ns >> (msb - sub_bits)) & (sub_buckets - 1);
+        return (msb - sub_bits + 1) * sub_buckets + sub;
+    }
+
+    static uint64_t lowest(int bucket) {
+        if (bucket < sub_buckets) {
+            return bucket;
+        }
+        const int msb = bucket / sub_buckets + sub_bits - 1;
+        const uint64_t sub = bucket % sub_buckets;
+        return (sub_buckets + sub) << (msb - sub_bits);
+    }
+
+private:
+    uint64_t m_counts[no_buckets] = {};
+    uint64_t m_total = 0;
+    uint64_t m_max = 0;
+};
+
+#endif // LATENCY_HISTOGRAM_HPP
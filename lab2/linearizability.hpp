@@ -0,0 +1,240 @@
+#ifndef LINEARIZABILITY_HPP
+#define LINEARIZABILITY_HPP
+
+// Offline linearizability checking of counter histories, see
+// test_linearizability.cpp.
+//
+// A history is the list of all operations of a run with the times at which
+// they were invoked and returned. It is linearizable if every operation can
+// be assigned a point between its invocation and its return at which it took
+// effect, such that executing the operations one at a time in that order on
+// a sequential counter gives the results that were observed.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <unordered_set>
+#include <vector>
+
+/*******************************************************************************
+ *                                   History                                   *
+ ******************************************************************************/
+
+enum class counter_op : uint8_t { increment, decrement, get };
+
+struct history_op {
+    counter_op op;
+    int thread_id;
+    // The value returned: the prior value for increment and decrement
+    int64_t result;
+    // Monotonic clock in ns
+    uint64_t invoked;
+    uint64_t returned;
+};
+
+// Timestamps come from the monotonic clock rather than from a shared atomic
+// counter: an RMW on a shared variable around every operation would act as a
+// full fence and hide exactly the reorderings the checker is meant to find.
+// On Linux the clock is read with an ordered TSC read, which is consistent
+// across cores.
+inline uint64_t history_now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+inline const char *counter_op_name(counter_op op) {
+    switch (op) {
+    case counter_op::increment:
+        return "increment";
+    case counter_op::decrement:
+        return "decrement";
+    default:
+        return "get";
+    }
+}
+
+/*******************************************************************************
+ *                                   Checker                                   *
+ ******************************************************************************/
+
+// Wing and Gong's search, with the memoization of Lowe, "Testing for
+// linearizability", 2017. The invocations and returns of all operations form
+// a time ordered list. The search repeatedly picks an operation whose
+// invocation precedes the first pending return, applies it to the sequential
+// counter and, if the result matches, removes it from the list. If the first
+// entry is a return, the operation it belongs to could not be linearized
+// before it and the search backtracks. The pairs of linearized operations
+// and counter value that have already been explored are cached, which keeps
+// the search close to linear for the histories of correct counters.
+class linearizability_checker {
+    struct entry {
+        bool is_call;
+        int op;
+        uint64_t time;
+        entry *match = nullptr;
+        entry *prev = nullptr;
+        entry *next = nullptr;
+    };
+
+    struct config {
+        std::vector<uint64_t> linearized;
+        int64_t value;
+
+        bool operator==(const config &other) const {
+            return value == other.value && linearized == other.linearized;
+        }
+    };
+
+    struct config_hash {
+        size_t operator()(const config &c) const {
+            size_t h = std::hash<int64_t>()(c.value);
+            for (uint64_t word : c.linearized) {
+                h = h * 1099511628211ull ^ word;
+            }
+            return h;
+        }
+    };
+
+    const std::vector<history_op> &m_history;
+    std::vector<entry> m_entries;
+    entry m_head;
+
+    // The deepest point the search reached, for the report
+    std::vector<uint64_t> m_best;
+    size_t m_best_count = 0;
+    int64_t m_best_value = 0;
+
+    static void lift(entry *call) {
+        call->prev->next = call->next;
+        call->next->prev = call->prev;
+        entry *ret = call->match;
+        ret->prev->next = ret->next;
+        if (ret->next) {
+            ret->next->prev = ret->prev;
+        }
+    }
+
+    static void unlift(entry *call) {
+        entry *ret = call->match;
+        ret->prev->next = ret;
+        if (ret->next) {
+            ret->next->prev = ret;
+        }
+        call->prev->next = call;
+        call->next->prev = call;
+    }
+
+    // Applies op to value, returns false if its result doesn't match
+    bool apply(const history_op &op, int64_t &value) const {
+        if (op.result != value) {
+            return false;
+        }
+        if (op.op == counter_op::increment) {
+            value++;
+        } else if (op.op == counter_op::decrement) {
+            value--;
+        }
+        return true;
+    }
+
+public:
+    explicit linearizability_checker(const std::vector<history_op> &history)
+        : m_history(history), m_entries(2 * history.size()) {
+        // A call sorts before a return with the same timestamp, the two
+        // operations are then considered concurrent.
+        for (size_t i = 0; i < history.size(); ++i) {
+            m_entries[2 * i] = {true, int(i), history[i].invoked};
+            m_entries[2 * i + 1] = {false, int(i), history[i].returned};
+            m_entries[2 * i].match = &m_entries[2 * i + 1];
+        }
+        std::vector<entry *> order;
+        for (entry &e : m_entries) {
+            order.push_back(&e);
+        }
+        std::sort(order.begin(), order.end(), [](entry *a, entry *b) {
+            return a->time != b->time ? a->time < b->time
+                                      : a->is_call > b->is_call;
+        });
+        entry *prev = &m_head;
+        for (entry *e : order) {
+            prev->next = e;
+            e->prev = prev;
+            prev = e;
+        }
+    }
+
+    // Returns true if the history is linearizable for a counter that starts
+    // at initial
+    bool check(int64_t initial) {
+        const size_t words = (m_history.size() + 63) / 64;
+        std::unordered_set<config, config_hash> seen;
+        std::vector<std::pair<entry *, int64_t>> stack;
+        config current = {std::vector<uint64_t>(words), initial};
+        entry *e = m_head.next;
+
+        while (m_head.next) {
+            if (e->is_call) {
+                int64_t value = current.value;
+                if (apply(m_history[e->op], value)) {
+                    config next = current;
+                    next.linearized[e->op / 64] |= 1ull << (e->op % 64);
+                    next.value = value;
+                    if (seen.insert(next).second) {
+                        stack.emplace_back(e, current.value);
+                        current = std::move(next);
+                        lift(e);
+                        if (stack.size() > m_best_count) {
+                            m_best_count = stack.size();
+                            m_best = current.linearized;
+                            m_best_value = current.value;
+                        }
+                        e = m_head.next;
+                        continue;
+                    }
+                }
+                e = e->next;
+            } else {
+                if (stack.empty()) {
+                    return false;
+                }
+                entry *call = stack.back().first;
+                current.value = stack.back().second;
+                current.linearized[call->op / 64] &= ~(1ull << (call->op % 64));
+                stack.pop_back();
+                unlift(call);
+                e = call->next;
+            }
+        }
+        return true;
+    }
+
+    // After a failed check(): prints the counter value at the deepest point
+    // the search reached and the operations that could have been next
+    void report(std::ostream &out) const {
+        auto done = [&](size_t i) {
+            return !m_best.empty() && (m_best[i / 64] >> (i % 64)) & 1;
+        };
+        uint64_t first_return = UINT64_MAX;
+        for (size_t i = 0; i < m_history.size(); ++i) {
+            if (!done(i)) {
+                first_return = std::min(first_return, m_history[i].returned);
+            }
+        }
+        out << "Linearized " << m_best_count << " of " << m_history.size()
+            << " operations, the counter is then " << m_best_value
+            << ", none of the candidates for the next operation match:\n";
+        for (size_t i = 0; i < m_history.size(); ++i) {
+            const history_op &op = m_history[i];
+            if (!done(i) && op.invoked <= first_return) {
+                out << "\tthread " << op.thread_id << ": "
+                    << counter_op_name(op.op) << "() = " << op.result
+                    << " [" << op.invoked << ", " << op.returned << "]\n";
+            }
+        }
+    }
+};
+
+#endif // LINEARIZABILITY_HPP
@@ -0,0 +1,218 @@
+#ifndef LOCK_PROFILE_HPP
+#define LOCK_PROFILE_HPP
+
+// Contention profiler for the user locks, included by user_locks.hpp.
+// Compiling with -DLOCK_PROFILE (make PROFILE=1) makes user_lock_visit() and
+// user_lock_create() wrap every lock in a profiled_lock, so all tests and
+// benchmarks are profiled without changes. Without it this header is not
+// included at all and the locks run unwrapped.
+//
+// A profiled_lock measures, per acquisition, the time from the call to lock()
+// until the lock is held (wait) and from then until unlock() (hold), and
+// counts the acquisitions that take the lock from another thread (handoffs).
+// Every depth_sample_interval:th acquisition of a thread also counts the
+// threads that are waiting for the lock at that moment (queue depth).
+//
+// The statistics are kept in per-thread buffers, the only shared state that
+// the profiler writes is the id of the last holder, which is written by the
+// holder inside the critical section. When a profiled lock is destroyed its
+// statistics are added to those of all earlier locks with the same name, and
+// at process exit they are written as HdrHistogram style percentile
+// distributions (see latency_histogram::write_percentiles()) to
+// $LOCK_PROFILE_FILE, or to stderr if that is not set.
+
+#include "latency_histogram.hpp"
+#include "sync_common.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*******************************************************************************
+ *                             Process-wide report                             *
+ ******************************************************************************/
+
+// The statistics of all profiled locks with the same name
+struct lock_profile_summary {
+    std::string label;
+    uint64_t locks = 0;
+    int max_threads = 0;
+    uint64_t acquisitions = 0;
+    uint64_t handoffs = 0;
+    // Wait and hold times in ns
+    latency_histogram wait;
+    latency_histogram hold;
+    // Number of waiting threads, sampled
+    latency_histogram depth;
+};
+
+class lock_profile_report {
+    std::mutex m_mutex;
+    std::vector<lock_profile_summary> m_summaries;
+
+    lock_profile_report() = default;
+
+public:
+    // The report is written when this instance is destroyed at exit.
+    // profiled_lock gets it in its constructor, so the instance is
+    // constructed before and destroyed after every profiled lock.
+    static lock_profile_report &instance() {
+        static lock_profile_report report;
+        return report;
+    }
+
+    // Adds the statistics of one lock to the summary of its label
+    template <typename F>
+    void add(const char *label, F &&merge) {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        for (lock_profile_summary &s : m_summaries) {
+            if (s.label == label) {
+                merge(s);
+                return;
+            }
+        }
+        m_summaries.emplace_back();
+        m_summaries.back().label = label;
+        merge(m_summaries.back());
+    }
+
+    void write(std::ostream &out) const {
+        for (const lock_profile_summary &s : m_summaries) {
+            out << "# Lock profile: " << s.label << " (" << s.locks
+                << " lock(s), up to " << s.max_threads << " threads)\n"
+                << "# Acquisitions: " << s.acquisitions
+                << ", handoffs: " << s.handoffs << " ("
+                << (s.acquisitions ? 100.0 * s.handoffs / s.acquisitions : 0)
+                << "%)\n\n# Wait time (us)\n";
+            s.wait.write_percentiles(out, 1000);
+            out << "\n# Hold time (us)\n";
+            s.hold.write_percentiles(out, 1000);
+            out << "\n# Queue depth (waiting threads)\n";
+            s.depth.write_percentiles(out);
+            out << "\n";
+        }
+    }
+
+    ~lock_profile_report() {
+        if (m_summaries.empty()) {
+            return;
+        }
+        const char *file = getenv("LOCK_PROFILE_FILE");
+        if (!file || !*file) {
+            write(std::cerr);
+            return;
+        }
+        std::ofstream out(file);
+        write(out);
+        if (!out) {
+            std::cerr << "Failed to write the lock profile to " << file
+                      << "\n";
+        }
+    }
+};
+
+/*******************************************************************************
+ *                                Profiled lock                                *
+ ******************************************************************************/
+
+template <typename Lock>
+class profiled_lock final : public user_lock {
+    // Written only by its thread
+    struct alignas(CACHE_LINE_SIZE) thread_profile {
+        uint64_t acquired_at = 0;
+        uint64_t acquisitions = 0;
+        uint64_t handoffs = 0;
+        latency_histogram wait;
+        latency_histogram hold;
+        latency_histogram depth;
+    };
+
+    std::unique_ptr<Lock> m_lock;
+    const char *m_label;
+    int m_max_threads;
+
+    std::unique_ptr<thread_profile[]> m_threads;
+    // Set while a thread is in lock(). Kept apart from the thread profiles
+    // so that sampling the queue depth does not pull their cache lines.
+    std::unique_ptr<padded<std::atomic<bool>>[]> m_waiting;
+    // The last holder, -1 before the first acquisition. Only accessed while
+    // holding the lock.
+    padded<int> m_owner = {-1};
+
+    static uint64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+public:
+    static constexpr const char *name = Lock::name;
+    static constexpr int thread_limit = Lock::thread_limit;
+
+    // The queue depth is sampled on every depth_sample_interval:th
+    // acquisition of a thread, sampling scans the flags of all threads.
+    static const int depth_sample_interval = 16;
+
+    // Takes ownership of lock, which is used by the threads 0 to
+    // max_threads - 1. The statistics are reported under label.
+    profiled_lock(Lock *lock, int max_threads, const char *label = Lock::name)
+        : m_lock(lock), m_label(label), m_max_threads(max_threads),
+          m_threads(new thread_profile[max_threads]),
+          m_waiting(new padded<std::atomic<bool>>[max_threads]) {
+        lock_profile_report::instance();
+        for (int i = 0; i < max_threads; ++i) {
+            m_waiting[i].value.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    ~profiled_lock() override {
+        lock_profile_report::instance().add(
+            m_label, [&](lock_profile_summary &s) {
+                s.locks++;
+                s.max_threads = std::max(s.max_threads, m_max_threads);
+                for (int i = 0; i < m_max_threads; ++i) {
+                    const thread_profile &t = m_threads[i];
+                    s.acquisitions += t.acquisitions;
+                    s.handoffs += t.handoffs;
+                    s.wait.merge(t.wait);
+                    s.hold.merge(t.hold);
+                    s.depth.merge(t.depth);
+                }
+            });
+    }
+
+    void lock(int thread_id) override {
+        thread_profile &t = m_threads[thread_id];
+        m_waiting[thread_id].value.store(true, std::memory_order_relaxed);
+        const uint64_t start = now_ns();
+        m_lock->lock(thread_id);
+        t.acquired_at = now_ns();
+        m_waiting[thread_id].value.store(false, std::memory_order_relaxed);
+
+        t.wait.record(t.acquired_at - start);
+        if (m_owner.value != thread_id) {
+            t.handoffs += m_owner.value >= 0;
+            m_owner.value = thread_id;
+        }
+        if (++t.acquisitions % depth_sample_interval == 0) {
+            uint64_t waiting = 0;
+            for (int i = 0; i < m_max_threads; ++i) {
+                waiting += m_waiting[i].value.load(std::memory_order_relaxed);
+            }
+            t.depth.record(waiting);
+        }
+    }
+
+    void unlock(int thread_id) override {
+        thread_profile &t = m_threads[thread_id];
+        t.hold.record(now_ns() - t.acquired_at);
+        m_lock->unlock(thread_id);
+    }
+};
+
+#endif // LOCK_PROFILE_HPP
@@ -0,0 +1,68 @@
+#ifndef LOCKFREE_HPP
+#define LOCKFREE_HPP
+
+#include "ms_queue.hpp"
+#include "reclamation.hpp"
+#include "treiber_stack.hpp"
+
+/*******************************************************************************
+ *                  Lock-free structures and their dispatch                    *
+ ******************************************************************************/
+
+// Uniform interface for the tests and benchmarks of the lock-free structures
+// (see lockfree_visit()). put() adds a value and take() removes one, the
+// order depends on the structure.
+
+template <typename Reclaimer>
+void put(treiber_stack<Reclaimer> &s, int thread_id, uint64_t value) {
+    s.push(thread_id, value);
+}
+
+template <typename Reclaimer>
+bool take(treiber_stack<Reclaimer> &s, int thread_id, uint64_t &value) {
+    return s.pop(thread_id, value);
+}
+
+template <typename Reclaimer>
+void put(ms_queue<Reclaimer> &q, int thread_id, uint64_t value) {
+    q.enqueue(thread_id, value);
+}
+
+template <typename Reclaimer>
+bool take(ms_queue<Reclaimer> &q, int thread_id, uint64_t &value) {
+    return q.dequeue(thread_id, value);
+}
+
+// Names of all structures, terminated by nullptr
+inline const char *const lockfree_names[] = {"treiber", "msqueue", nullptr};
+
+/**
+ * Creates the structure with the given name, using the reclaimer with the
+ * given name, for max_threads threads and calls f with a reference to it.
+ * E.g.:
+ *
+ * lockfree_visit("msqueue", "ebr", 4, [](auto &q) { put(q, 0, 42); });
+ *
+ * Returns:
+ *	false if there is no structure or reclaimer with that name.
+ */
+template <typename F>
+bool lockfree_visit(const char *structure, const char *reclaimer,
+                    int max_threads, F &&f) {
+    bool found = false;
+    const bool reclaimer_found = reclaimer_visit(reclaimer, [&](auto *tag) {
+        using Reclaimer = std::remove_pointer_t<decltype(tag)>;
+        if (strcmp(structure, treiber_stack<Reclaimer>::name) == 0) {
+            treiber_stack<Reclaimer> s(max_threads);
+            f(s);
+            found = true;
+        } else if (strcmp(structure, ms_queue<Reclaimer>::name) == 0) {
+            ms_queue<Reclaimer> q(max_threads);
+            f(q);
+            found = true;
+        }
+    });
+    return reclaimer_found && found;
+}
+
+#endif // LOCKFREE_HPP
@@ -0,0 +1,119 @@
+#ifndef MS_QUEUE_HPP
+#define MS_QUEUE_HPP
+
+#include "reclamation.hpp"
+
+/*******************************************************************************
+ *                    Michael-Scott lock-free FIFO queue                       *
+ ******************************************************************************/
+
+// Michael and Scott, "Simple, Fast, and Practical Non-Blocking and Blocking
+// Concurrent Queue Algorithms". A linked list with a dummy node at the head,
+// dequeue() moves m_head to the next node, which becomes the new dummy, and
+// retires the old one through the Reclaimer. Unlike work_queue it is
+// unbounded.
+
+template <typename Reclaimer>
+class ms_queue {
+private:
+    struct node {
+        // Written before the node is published, read by the dequeuer that
+        // makes it the new dummy node
+        uint64_t value;
+        std::atomic<node *> next;
+    };
+
+    alignas(CACHE_LINE_SIZE) std::atomic<node *> m_head;
+    alignas(CACHE_LINE_SIZE) std::atomic<node *> m_tail;
+    Reclaimer m_reclaimer;
+
+public:
+    static constexpr const char *name = "msqueue";
+    // Size of the nodes, for memory footprint estimates
+    static const size_t node_size = sizeof(node);
+
+    // max_threads: threads may use the ids 0 to max_threads - 1
+    explicit ms_queue(int max_threads = MAX_THREADS)
+        : m_reclaimer(max_threads) {
+        node *dummy = new node{0, {nullptr}};
+        m_head.store(dummy, std::memory_order_relaxed);
+        m_tail.store(dummy, std::memory_order_relaxed);
+    }
+
+    // Not thread safe, no other thread may use the queue
+    ~ms_queue() {
+        node *n = m_head.load(std::memory_order_relaxed);
+        while (n) {
+            node *next = n->next.load(std::memory_order_relaxed);
+            delete n;
+            n = next;
+        }
+    }
+
+    void enqueue(int thread_id, uint64_t value) {
+        node *n = new node{value, {nullptr}};
+        m_reclaimer.enter(thread_id);
+        for (;;) {
+            node *tail = m_reclaimer.protect(thread_id, 0, m_tail);
+            node *next = tail->next.load(std::memory_order_acquire);
+            if (next) {
+                // The tail is lagging behind, help the enqueuer that linked
+                // next to move it
+                m_tail.compare_exchange_weak(tail, next,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed);
+                continue;
+            }
+            if (tail->next.compare_exchange_weak(next, n,
+                                                 std::memory_order_release,
+                                                 std::memory_order_relaxed)) {
+                m_tail.compare_exchange_strong(tail, n,
+                                               std::memory_order_release,
+                                               std::memory_order_relaxed);
+                break;
+            }
+        }
+        m_reclaimer.leave(thread_id);
+    }
+
+    // Returns false if the queue is empty
+    bool dequeue(int thread_id, uint64_t &value) {
+        m_reclaimer.enter(thread_id);
+        for (;;) {
+            node *head = m_reclaimer.protect(thread_id, 0, m_head);
+            node *next = m_reclaimer.protect(thread_id, 1, head->next);
+            // next is only safe to use if head was still the head after we
+            // protected next, otherwise it may already have been retired
+            if (head != m_head.load(std::memory_order_acquire)) {
+                continue;
+            }
+            if (!next) {
+                m_reclaimer.leave(thread_id);
+                return false;
+            }
+            // Never let m_head pass m_tail, the tail would point to a
+            // retired node
+            node *tail = m_tail.load(std::memory_order_acquire);
+            if (head == tail) {
+                m_tail.compare_exchange_weak(tail, next,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed);
+                continue;
+            }
+            value = next->value;
+            if (m_head.compare_exchange_weak(head, next,
+                                             std::memory_order_acq_rel,
+                                             std::memory_order_relaxed)) {
+                m_reclaimer.retire(thread_id, head);
+                m_reclaimer.leave(thread_id);
+                return true;
+            }
+        }
+    }
+
+    Reclaimer &reclaimer() {
+        return m_reclaimer;
+    }
+};
+
+#endif // MS_QUEUE_HPP
@@ -0,0 +1,115 @@
+#ifndef RECLAIMER_EBR_HPP
+#define RECLAIMER_EBR_HPP
+
+#include "reclamation.hpp"
+
+inline reclaimer_ebr::reclaimer_ebr(int max_threads)
+    : m_epoch(0)
+    , m_threads(new thread_rec[max_threads])
+    , m_no_threads(max_threads) {
+    for (int t = 0; t < max_threads; ++t) {
+        m_threads[t].local.store(0, std::memory_order_relaxed);
+        m_threads[t].since_collect = 0;
+        m_threads[t].no_retired.store(0, std::memory_order_relaxed);
+        m_threads[t].no_freed.store(0, std::memory_order_relaxed);
+    }
+}
+
+inline reclaimer_ebr::~reclaimer_ebr() {
+    drain();
+}
+
+inline void reclaimer_ebr::enter(int thread_id) {
+    const uint64_t epoch = m_epoch.load(std::memory_order_relaxed);
+    m_threads[thread_id].local.store(epoch << 1 | 1,
+                                     std::memory_order_relaxed);
+    // The announcement has to be visible before we read any pointers from
+    // the structure (store->load), pairs with the fence in collect()
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+inline void reclaimer_ebr::leave(int thread_id) {
+    m_threads[thread_id].local.store(0, std::memory_order_release);
+}
+
+template <typename T>
+inline T *reclaimer_ebr::protect(int, int, const std::atomic<T *> &src) {
+    return src.load(std::memory_order_acquire);
+}
+
+template <typename T>
+inline void reclaimer_ebr::retire(int thread_id, T *node) {
+    thread_rec &me = m_threads[thread_id];
+    // The node is tagged with the global epoch e read after it was unlinked,
+    // not with our announced epoch, which may already be one behind. The
+    // epoch only grows, so it was at most e when the node was unlinked. A
+    // thread that can still hold the node loaded it before the unlink, so it
+    // entered in epoch e or earlier and has not left since. While it is
+    // active it has announced at most e, which keeps the global epoch from
+    // reaching e + 2. Threads that enter later cannot reach the node.
+    me.retired.push_back(
+        retired_ptr::of(node, m_epoch.load(std::memory_order_seq_cst)));
+    me.no_retired.store(me.no_retired.load(std::memory_order_relaxed) + 1,
+                        std::memory_order_relaxed);
+    if (++me.since_collect >= collect_interval) {
+        me.since_collect = 0;
+        collect(thread_id);
+    }
+}
+
+inline void reclaimer_ebr::collect(int thread_id) {
+    thread_rec &me = m_threads[thread_id];
+
+    // Try to advance the epoch, which requires that every active thread has
+    // announced the current one
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint64_t epoch = m_epoch.load(std::memory_order_relaxed);
+    bool all_current = true;
+    for (int t = 0; t < m_no_threads && all_current; ++t) {
+        const uint64_t local =
+            m_threads[t].local.load(std::memory_order_acquire);
+        all_current = !(local & 1) || local >> 1 == epoch;
+    }
+    if (all_current &&
+        m_epoch.compare_exchange_strong(epoch, epoch + 1,
+                                        std::memory_order_acq_rel)) {
+        epoch++;
+    }
+
+    size_t kept = 0;
+    for (const retired_ptr &r : me.retired) {
+        if (r.epoch + 2 <= epoch) {
+            r.deleter(r.ptr);
+        } else {
+            me.retired[kept++] = r;
+        }
+    }
+    me.no_freed.store(me.no_freed.load(std::memory_order_relaxed) +
+                          me.retired.size() - kept,
+                      std::memory_order_relaxed);
+    me.retired.resize(kept);
+}
+
+inline uint64_t reclaimer_ebr::pending() const {
+    uint64_t retired = 0, freed = 0;
+    for (int t = 0; t < m_no_threads; ++t) {
+        retired += m_threads[t].no_retired.load(std::memory_order_relaxed);
+        freed += m_threads[t].no_freed.load(std::memory_order_relaxed);
+    }
+    return retired - freed;
+}
+
+inline void reclaimer_ebr::drain() {
+    for (int t = 0; t < m_no_threads; ++t) {
+        thread_rec &rec = m_threads[t];
+        for (const retired_ptr &r : rec.retired) {
+            r.deleter(r.ptr);
+        }
+        rec.no_freed.store(rec.no_freed.load(std::memory_order_relaxed) +
+                               rec.retired.size(),
+                           std::memory_order_relaxed);
+        rec.retired.clear();
+    }
+}
+
+#endif // RECLAIMER_EBR_HPP
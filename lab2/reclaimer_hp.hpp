@@ -0,0 +1,114 @@
+#ifndef RECLAIMER_HP_HPP
+#define RECLAIMER_HP_HPP
+
+#include "reclamation.hpp"
+
+inline reclaimer_hp::reclaimer_hp(int max_threads)
+    : m_threads(new thread_rec[max_threads])
+    , m_no_threads(max_threads)
+    , m_scan_threshold(std::max(64, 2 * protect_slots * max_threads)) {
+    for (int t = 0; t < max_threads; ++t) {
+        for (auto &hazard : m_threads[t].hazards) {
+            hazard.store(nullptr, std::memory_order_relaxed);
+        }
+        m_threads[t].no_retired.store(0, std::memory_order_relaxed);
+        m_threads[t].no_freed.store(0, std::memory_order_relaxed);
+    }
+}
+
+inline reclaimer_hp::~reclaimer_hp() {
+    drain();
+}
+
+inline void reclaimer_hp::enter(int) {
+}
+
+inline void reclaimer_hp::leave(int thread_id) {
+    for (auto &hazard : m_threads[thread_id].hazards) {
+        hazard.store(nullptr, std::memory_order_release);
+    }
+}
+
+template <typename T>
+inline T *reclaimer_hp::protect(int thread_id, int index,
+                                const std::atomic<T *> &src) {
+    std::atomic<void *> &hazard = m_threads[thread_id].hazards[index];
+    T *p = src.load(std::memory_order_relaxed);
+    for (;;) {
+        hazard.store(p, std::memory_order_relaxed);
+        // The hazard pointer has to be visible before we check that the
+        // node is still reachable (store->load), a thread that retires it
+        // after the check will then see the hazard pointer in scan().
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        T *again = src.load(std::memory_order_acquire);
+        if (again == p) {
+            return p;
+        }
+        p = again;
+    }
+}
+
+template <typename T>
+inline void reclaimer_hp::retire(int thread_id, T *node) {
+    thread_rec &me = m_threads[thread_id];
+    me.retired.push_back(retired_ptr::of(node));
+    me.no_retired.store(me.no_retired.load(std::memory_order_relaxed) + 1,
+                        std::memory_order_relaxed);
+    if (me.retired.size() >= m_scan_threshold) {
+        scan(thread_id);
+    }
+}
+
+inline void reclaimer_hp::scan(int thread_id) {
+    thread_rec &me = m_threads[thread_id];
+
+    // Pairs with the fence in protect(): either the other thread sees that
+    // the node has been unlinked, or we see its hazard pointer
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::vector<void *> hazards;
+    for (int t = 0; t < m_no_threads; ++t) {
+        for (auto &hazard : m_threads[t].hazards) {
+            if (void *p = hazard.load(std::memory_order_acquire)) {
+                hazards.push_back(p);
+            }
+        }
+    }
+    std::sort(hazards.begin(), hazards.end());
+
+    size_t kept = 0;
+    for (const retired_ptr &r : me.retired) {
+        if (std::binary_search(hazards.begin(), hazards.end(), r.ptr)) {
+            me.retired[kept++] = r;
+        } else {
+            r.deleter(r.ptr);
+        }
+    }
+    me.no_freed.store(me.no_freed.load(std::memory_order_relaxed) +
+                          me.retired.size() - kept,
+                      std::memory_order_relaxed);
+    me.retired.resize(kept);
+}
+
+inline uint64_t reclaimer_hp::pending() const {
+    uint64_t retired = 0, freed = 0;
+    for (int t = 0; t < m_no_threads; ++t) {
+        retired += m_threads[t].no_retired.load(std::memory_order_relaxed);
+        freed += m_threads[t].no_freed.load(std::memory_order_relaxed);
+    }
+    return retired - freed;
+}
+
+inline void reclaimer_hp::drain() {
+    for (int t = 0; t < m_no_threads; ++t) {
+        thread_rec &rec = m_threads[t];
+        for (const retired_ptr &r : rec.retired) {
+            r.deleter(r.ptr);
+        }
+        rec.no_freed.store(rec.no_freed.load(std::memory_order_relaxed) +
+                               rec.retired.size(),
+                           std::memory_order_relaxed);
+        rec.retired.clear();
+    }
+}
+
+#endif // RECLAIMER_HP_HPP
@@ -0,0 +1,206 @@
+#ifndef RECLAMATION_HPP
+#define RECLAMATION_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "sync_common.hpp"
+
+/*******************************************************************************
+ *                          Safe memory reclamation                            *
+ ******************************************************************************/
+
+// A lock-free structure cannot delete a node as soon as it has unlinked it,
+// other threads may still be reading it. It retires the node instead, and a
+// reclaimer frees it once no thread can hold a reference to it any more.
+//
+// The reclaimers are policies that lock-free structures take as a template
+// parameter (see treiber_stack and ms_queue). They all provide the same
+// interface, thread_id is between 0 and the max_threads passed to the
+// constructor:
+//
+//	void enter(int thread_id)
+//	void leave(int thread_id)
+//		Bracket every operation on the structure. Pointers obtained from
+//		protect() may only be used in between.
+//
+//	T *protect(int thread_id, int index, const std::atomic<T *> &src)
+//		Loads a pointer from src and makes sure that the node it points
+//		to is not freed before leave() (or until index is reused). index
+//		is between 0 and protect_slots - 1.
+//
+//	void retire(int thread_id, T *node)
+//		Deletes node once no other thread can access it. The node must
+//		already be unreachable for threads that enter() after this call.
+//		Must be called before leave().
+//
+//	uint64_t pending() const
+//		The number of nodes that have been retired but not freed yet.
+//
+//	void drain()
+//		Frees all retired nodes, no other thread may use the reclaimer
+//		at the same time.
+
+// A node waiting to be freed
+struct retired_ptr {
+    void *ptr;
+    void (*deleter)(void *);
+    // The epoch it was retired in, only used by reclaimer_ebr
+    uint64_t epoch;
+
+    template <typename T>
+    static retired_ptr of(T *node, uint64_t epoch = 0) {
+        return {node, [](void *p) { delete static_cast<T *>(p); }, epoch};
+    }
+};
+
+/*******************************************************************************
+ *                               Hazard pointers                               *
+ ******************************************************************************/
+
+// Michael, "Hazard Pointers: Safe Memory Reclamation for Lock-Free Objects".
+// Every thread publishes the nodes it is about to access in its hazard
+// pointers. A thread frees its retired nodes in batches, skipping the ones
+// that are in some thread's hazard pointers. At most
+// max_threads * protect_slots retired nodes can be kept alive at any time,
+// but every protect() costs a store->load fence.
+
+class reclaimer_hp final {
+public:
+    static constexpr const char *name = "hp";
+    static const int protect_slots = 2;
+
+private:
+    struct alignas(CACHE_LINE_SIZE) thread_rec {
+        std::atomic<void *> hazards[protect_slots];
+        std::vector<retired_ptr> retired;
+        // Only written by the owner, read by pending()
+        std::atomic<uint64_t> no_retired;
+        std::atomic<uint64_t> no_freed;
+    };
+
+    std::unique_ptr<thread_rec[]> m_threads;
+    int m_no_threads;
+    // Scan when a thread has this many retired nodes, a multiple of the
+    // number of hazard pointers so that every scan frees a share of them
+    size_t m_scan_threshold;
+
+    void scan(int thread_id);
+
+public:
+    explicit reclaimer_hp(int max_threads = MAX_THREADS);
+    ~reclaimer_hp();
+
+    void enter(int thread_id);
+    void leave(int thread_id);
+    template <typename T>
+    T *protect(int thread_id, int index, const std::atomic<T *> &src);
+    template <typename T>
+    void retire(int thread_id, T *node);
+    uint64_t pending() const;
+    void drain();
+};
+
+/*******************************************************************************
+ *                         Epoch-based reclamation                             *
+ ******************************************************************************/
+
+// Fraser, "Practical lock-freedom", Section 5.2.3. Threads announce the
+// global epoch when they enter(). The epoch can only advance when all active
+// threads have announced the current one, so a node retired while the global
+// epoch is e can be freed once the global epoch is e + 2 (see retire()).
+// enter() and leave() are cheap and protect() is a plain load, but a thread
+// that stalls inside an operation keeps all threads from freeing anything.
+
+class reclaimer_ebr final {
+public:
+    static constexpr const char *name = "ebr";
+    static const int protect_slots = 2;
+
+private:
+    struct alignas(CACHE_LINE_SIZE) thread_rec {
+        // (epoch << 1) | 1 while the thread is between enter() and leave(),
+        // 0 otherwise
+        std::atomic<uint64_t> local;
+        std::vector<retired_ptr> retired;
+        // Retired nodes since the thread last tried to free some
+        unsigned since_collect;
+        std::atomic<uint64_t> no_retired;
+        std::atomic<uint64_t> no_freed;
+    };
+
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> m_epoch;
+    std::unique_ptr<thread_rec[]> m_threads;
+    int m_no_threads;
+
+    // Number of retired nodes between attempts to advance the epoch
+    static const unsigned collect_interval = 64;
+
+    void collect(int thread_id);
+
+public:
+    explicit reclaimer_ebr(int max_threads = MAX_THREADS);
+    ~reclaimer_ebr();
+
+    void enter(int thread_id);
+    void leave(int thread_id);
+    template <typename T>
+    T *protect(int thread_id, int index, const std::atomic<T *> &src);
+    template <typename T>
+    void retire(int thread_id, T *node);
+    uint64_t pending() const;
+    void drain();
+};
+
+/*******************************************************************************
+ *                         Implementations and dispatch                        *
+ ******************************************************************************/
+
+#include "reclaimer_ebr.hpp"
+#include "reclaimer_hp.hpp"
+
+template <typename... Reclaimers>
+struct reclaimer_list {};
+
+using reclaimer_types = reclaimer_list<reclaimer_hp, reclaimer_ebr>;
+
+// Names of all reclaimers, terminated by nullptr
+inline const char *const reclaimer_names[] = {reclaimer_hp::name,
+                                              reclaimer_ebr::name, nullptr};
+
+template <typename F, typename... Reclaimers>
+bool reclaimer_visit(reclaimer_list<Reclaimers...>, const char *name, F &f) {
+    auto visit_one = [&](auto *type_tag) {
+        using Reclaimer = std::remove_pointer_t<decltype(type_tag)>;
+        if (strcmp(name, Reclaimer::name) != 0) {
+            return false;
+        }
+        f(type_tag);
+        return true;
+    };
+    return (visit_one(static_cast<Reclaimers *>(nullptr)) || ...);
+}
+
+/**
+ * Calls f with a null pointer of the type of the reclaimer with the given
+ * name, which f uses to instantiate a structure with it. E.g.:
+ *
+ * reclaimer_visit("hp", [](auto *tag) {
+ *     using Reclaimer = std::remove_pointer_t<decltype(tag)>;
+ *     treiber_stack<Reclaimer> stack(4);
+ * });
+ *
+ * Returns:
+ *	false if there is no reclaimer with that name.
+ */
+template <typename F>
+bool reclaimer_visit(const char *name, F &&f) {
+    return reclaimer_visit(reclaimer_types(), name, f);
+}
+
+#endif // RECLAMATION_HPP
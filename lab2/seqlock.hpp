@@ -0,0 +1,143 @@
+#ifndef SEQLOCK_HPP
+#define SEQLOCK_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "sync_common.hpp"
+#include "user_locks.hpp"
+
+/*******************************************************************************
+ *                     Sequence lock over any user_lock                        *
+ ******************************************************************************/
+
+// Optimistic reads for read-mostly data, a software alternative to lock
+// elision. Writers serialize on an ordinary lock (any user_lock, or the
+// user_lock base class) and make the sequence number odd while they update
+// the data. Readers do not write shared memory at all: they read the sequence
+// number, read the data and retry if the sequence number was odd or has
+// changed in the meantime. Readers therefore scale with the number of cores,
+// but can starve if writes are frequent.
+//
+// The readers race with the writers, so the protected data must be read and
+// written with atomic operations, e.g. by keeping it in a seqlock_data.
+// See Boehm, "Can Seqlocks Get Along With Programming Language Memory
+// Models?".
+//
+// Example:
+//
+// seqlock<user_lock_mcs> sl(lock);
+// seqlock_data<config> data;
+//
+// config c = sl.read([&]() { return data.load(); });
+//
+// sl.write_lock(thread_id);
+// data.store(new_config);
+// sl.write_unlock(thread_id);
+
+template <typename Lock>
+class seqlock {
+private:
+    Lock &m_lock;
+    // Odd while a writer updates the data
+    alignas(CACHE_LINE_SIZE) std::atomic<unsigned> m_seq;
+
+public:
+    // lock: the writer lock, must outlive the seqlock
+    explicit seqlock(Lock &lock)
+        : m_lock(lock)
+        , m_seq(0) {
+    }
+
+    // Starts a read, returns the sequence number to pass to read_retry()
+    unsigned read_begin() const {
+        unsigned seq;
+        while ((seq = m_seq.load(std::memory_order_acquire)) & 1) {
+            cpu_relax();
+        }
+        return seq;
+    }
+
+    // Returns true if a writer may have changed the data since
+    // read_begin() returned seq, the data read in between must be discarded
+    bool read_retry(unsigned seq) const {
+        // Orders the (relaxed) data loads before the sequence number load
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return m_seq.load(std::memory_order_relaxed) != seq;
+    }
+
+    // Runs f, which reads the data, until it has run without a concurrent
+    // write and returns its result
+    template <typename F>
+    auto read(F &&f) const {
+        for (;;) {
+            const unsigned seq = read_begin();
+            auto result = f();
+            if (!read_retry(seq)) {
+                return result;
+            }
+        }
+    }
+
+    void write_lock(int thread_id) {
+        m_lock.lock(thread_id);
+        // Only the writer holding the lock changes m_seq
+        m_seq.store(m_seq.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_relaxed);
+        // Orders the odd sequence number before the (relaxed) data stores
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void write_unlock(int thread_id) {
+        m_seq.store(m_seq.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_release);
+        m_lock.unlock(thread_id);
+    }
+};
+
+/*******************************************************************************
+ *                        Data protected by a seqlock                          *
+ ******************************************************************************/
+
+// Keeps a trivially copyable T in relaxed atomic 64-bit words, so that
+// readers of a seqlock can copy it while a writer updates it without a data
+// race. A copy made during a write may be torn, the seqlock tells the reader
+// to discard it.
+
+template <typename T>
+class seqlock_data {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "seqlock_data requires a trivially copyable type");
+
+private:
+    static const size_t no_words = (sizeof(T) + 7) / 8;
+    std::atomic<uint64_t> m_words[no_words];
+
+public:
+    explicit seqlock_data(const T &value = T()) {
+        store(value);
+    }
+
+    T load() const {
+        uint64_t words[no_words];
+        for (size_t i = 0; i < no_words; ++i) {
+            words[i] = m_words[i].load(std::memory_order_relaxed);
+        }
+        T value;
+        memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+    // May only be called between seqlock::write_lock() and write_unlock()
+    void store(const T &value) {
+        uint64_t words[no_words] = {};
+        memcpy(words, &value, sizeof(T));
+        for (size_t i = 0; i < no_words; ++i) {
+            m_words[i].store(words[i], std::memory_order_relaxed);
+        }
+    }
+};
+
+#endif // SEQLOCK_HPP
@@ -0,0 +1,178 @@
+#ifndef SYNC_COMMON_HPP
+#define SYNC_COMMON_HPP
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <linux/futex.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Size of a cache line. Data written by different threads is padded to
+// this size so that it does not end up in the same cache line (false
+// sharing).
+#define CACHE_LINE_SIZE 64
+
+// Maximum number of threads supported by the locks and counters that keep
+// per-thread state.
+#define MAX_THREADS 64
+
+/**
+ * Wraps a value so that it occupies (at least) one full cache line on its
+ * own. E.g.:
+ *
+ * padded<std::atomic<bool>> flags[2];
+ * flags[1].value.store(true);
+ */
+template <typename T>
+struct alignas(CACHE_LINE_SIZE) padded {
+    T value;
+};
+
+/**
+ * Tells the CPU that we are busy waiting. This reduces the power consumed
+ * while spinning, frees up resources for an SMT sibling and avoids the memory
+ * order mis-speculation penalty when the spin loop exits.
+ */
+static inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+// The futex syscall operates on a 32-bit int in memory. std::atomic<int> has
+// the same representation as an int on all platforms we care about.
+static_assert(sizeof(std::atomic<int>) == sizeof(int),
+              "std::atomic<int> cannot be used as a futex");
+
+inline long futex_syscall(std::atomic<int> *uaddr, int op, int val) {
+    return syscall(SYS_futex, reinterpret_cast<int *>(uaddr),
+                   op | FUTEX_PRIVATE_FLAG, val, nullptr, nullptr, 0);
+}
+
+// thread_slot_used[i] is true while slot i is owned by a running thread
+inline std::atomic<bool> thread_slot_used[MAX_THREADS];
+
+/**
+ * Returns a small id for the calling thread, between 0 and MAX_THREADS - 1 and
+ * unique among the running threads. The slot is assigned on first use and
+ * recycled when the thread exits. This is for per-thread state in classes
+ * whose interface does not pass a thread id (e.g. atomic_counter). Aborts if
+ * more than MAX_THREADS threads need a slot at the same time.
+ */
+inline int this_thread_slot() {
+    struct owner {
+        int slot = -1;
+
+        owner() {
+            for (int i = 0; i < MAX_THREADS; ++i) {
+                if (!thread_slot_used[i].load(std::memory_order_relaxed) &&
+                    !thread_slot_used[i].exchange(true,
+                                                  std::memory_order_acquire)) {
+                    slot = i;
+                    return;
+                }
+            }
+            std::cerr << "More than " << MAX_THREADS << " threads\n";
+            abort();
+        }
+
+        ~owner() {
+            thread_slot_used[slot].store(false, std::memory_order_release);
+        }
+    };
+    static thread_local owner o;
+    return o.slot;
+}
+
+/**
+ * Returns the NUMA node of every CPU, indexed by CPU number, as listed in
+ * /sys/devices/system/node/node<N>/cpulist. CPUs that are not listed there
+ * (or all CPUs if the directory does not exist) are put on node 0. The
+ * topology is read once, on first use.
+ */
+inline const std::vector<int> &cpu_numa_nodes() {
+    static const std::vector<int> nodes = []() {
+        std::vector<int> nodes;
+        // Node numbers can have holes, give up after a run of missing nodes
+        for (int node = 0, missing = 0; missing < 64; ++node) {
+            std::ifstream in("/sys/devices/system/node/node" +
+                             std::to_string(node) + "/cpulist");
+            std::string list;
+            if (!std::getline(in, list)) {
+                ++missing;
+                continue;
+            }
+            missing = 0;
+
+            // The list looks like "0-3,8-11"
+            std::istringstream ranges(list);
+            std::string range;
+            while (std::getline(ranges, range, ',')) {
+                int first, last;
+                const size_t dash = range.find('-');
+                first = std::atoi(range.c_str());
+                last = dash == std::string::npos
+                           ? first
+                           : std::atoi(range.c_str() + dash + 1);
+                for (int cpu = first; cpu <= last; ++cpu) {
+                    if (cpu >= (int)nodes.size()) {
+                        nodes.resize(cpu + 1, 0);
+                    }
+                    nodes[cpu] = node;
+                }
+            }
+        }
+        return nodes;
+    }();
+    return nodes;
+}
+
+// If $EMULATE_NUMA_NODES=<n> is set, the functions below pretend that there
+// are n nodes and that thread_id % n is the node of a thread. This exercises
+// NUMA-aware code paths on machines with a single node. 0 if not set.
+inline int emulated_numa_nodes() {
+    static const int nodes = []() {
+        const char *env = getenv("EMULATE_NUMA_NODES");
+        return env && atoi(env) > 0 ? atoi(env) : 0;
+    }();
+    return nodes;
+}
+
+// The number of NUMA nodes with CPUs, at least 1
+inline int numa_node_count() {
+    static const int count = []() {
+        if (emulated_numa_nodes()) {
+            return emulated_numa_nodes();
+        }
+        int max_node = 0;
+        for (int node : cpu_numa_nodes()) {
+            max_node = node > max_node ? node : max_node;
+        }
+        return max_node + 1;
+    }();
+    return count;
+}
+
+// The NUMA node the thread with the given id is currently running on
+inline int thread_numa_node(int thread_id) {
+    if (emulated_numa_nodes()) {
+        return thread_id % emulated_numa_nodes();
+    }
+    if (numa_node_count() == 1) {
+        return 0;
+    }
+    const std::vector<int> &nodes = cpu_numa_nodes();
+    const int cpu = sched_getcpu();
+    return cpu >= 0 && cpu < (int)nodes.size() ? nodes[cpu] : 0;
+}
+
+#endif // SYNC_COMMON_HPP
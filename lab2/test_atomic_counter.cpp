@@ -2,55 +2,49 @@
 #include "test_common.hpp"
 
 #include <chrono>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <thread>
+#include <vector>
+
+const int default_iterations = 50000000;
 
 void usage(char *argv[]) {
-    std::cerr << "Usage: " << argv[0] << " <TEST>\n\n"
-              << "Where <TEST> can be:\n"
-              << "\tnosync\n"
-              << "\tlock\n"
-              << "\tatomic_incdec\n"
-              << "\tatomic_cas\n";
+    std::cerr << "Usage: " << argv[0] << " <TEST> [THREADS] [ITERATIONS]\n\n"
+              << "Where <TEST> can be:\n";
+    for (const atomic_counter_info *info = atomic_counter_registry; info->name;
+         ++info) {
+        std::cerr << "\t" << info->name << "\n";
+    }
+    std::cerr << "\nAnd [THREADS] is an even number of threads between 2 and "
+              << MAX_THREADS << " (default: 2). Half of the threads\n"
+              << "increment and half of the threads decrement.\n"
+              << "[ITERATIONS] is the number of increments and decrements in\n"
+              << "the multithreaded tests (default: " << default_iterations
+              << "), lower it for slow counters.\n";
 }
 
-void increment_counter(atomic_counter *counter, int iterations) {
+// The test loops are templated on the counter type, so that the counter
+// operations can be inlined into them (see atomic_counter_visit()).
+
+template <typename Counter>
+void increment_counter(Counter *counter, int iterations) {
     for (int i = 0; i < iterations; ++i) {
         counter->increment();
     }
 }
 
-void decrement_counter(atomic_counter *counter, int iterations) {
+template <typename Counter>
+void decrement_counter(Counter *counter, int iterations) {
     for (int i = 0; i < iterations; ++i) {
         counter->decrement();
     }
 }
 
-int main(int argc, char *argv[]) {
-    // Check if the user has given us an argument
-    if (argc != 2) {
-        usage(argv);
-        return -1;
-    }
-
-    // Find what that argument was and initialize the appropriate test
-    std::unique_ptr<atomic_counter> counter = nullptr;
-    if (strcmp(argv[1], "nosync") == 0) {
-        counter.reset(new atomic_counter_nosync());
-    } else if (strcmp(argv[1], "lock") == 0) {
-        counter.reset(new atomic_counter_lock());
-    } else if (strcmp(argv[1], "atomic_incdec") == 0) {
-        counter.reset(new atomic_counter_atomic_incdec());
-    } else if (strcmp(argv[1], "atomic_cas") == 0) {
-        counter.reset(new atomic_counter_atomic_cas());
-    } else {
-        std::cerr << "Invalid <TEST> " << argv[1] << "\n";
-        usage(argv);
-        return -1;
-    }
-
-    // Test 1: Single threaded get and set
+// Test 1: Single threaded get and set
+template <typename Counter>
+int singlethreaded_tests(Counter *counter) {
     std::cout << "\n#1: Singlethreaded tests\n\n";
     counter->set(1);
     auto v = counter->get();
@@ -67,16 +61,51 @@ int main(int argc, char *argv[]) {
     v = counter->decrement();
     TEST_EQ(3, v, "counter->decrement()");
 
+    return 0;
+}
+
+// Runs the increment threads (even thread ids) and decrement threads (odd
+// thread ids) to completion.
+template <typename Counter>
+void run_threads(Counter *counter, int threads, int inc_iterations,
+                 int dec_iterations) {
+    std::vector<std::thread> workers;
+    for (int tid = 0; tid < threads; ++tid) {
+        if (tid % 2 == 0) {
+            workers.emplace_back(increment_counter<Counter>, counter,
+                                 inc_iterations);
+        } else {
+            workers.emplace_back(decrement_counter<Counter>, counter,
+                                 dec_iterations);
+        }
+    }
+
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+template <typename Counter>
+int run_tests(Counter *counter, const char *name, int threads,
+              int iterations) {
+    // Test 1: Single threaded get and set. Runs in a thread of its own, so
+    // that the main thread doesn't keep a thread slot (see this_thread_slot())
+    // while the worker threads of test 2 run.
+    int result = 0;
+    std::thread single_thread(
+        [&]() { result = singlethreaded_tests(counter); });
+    single_thread.join();
+    if (result != 0) {
+        return result;
+    }
+
     // Test 2: multithreaded increment and decrement
-    std::cout << "\n#2: Multithreaded tests\n\n";
-    const int iterations = 50000000;
+    std::cout << "\n#2: Multithreaded tests (" << threads << " threads)\n\n";
+    // Every thread does an equal share of the work of the two thread test
+    const int thread_iterations = iterations / (threads / 2);
     counter->set(0);
     auto start_time = std::chrono::high_resolution_clock::now();
-    std::thread inc_thread(increment_counter, counter.get(), iterations);
-    std::thread dec_thread(decrement_counter, counter.get(), iterations);
-
-    inc_thread.join();
-    dec_thread.join();
+    run_threads(counter, threads, thread_iterations, thread_iterations);
     auto end_time = std::chrono::high_resolution_clock::now();
     TEST_EQ(0, counter->get(), "equal inc/dec");
     std::chrono::duration<double> total_time = end_time - start_time;
@@ -84,12 +113,73 @@ int main(int argc, char *argv[]) {
     std::cout << "--> Performance: " << opss << " ops/s\n";
 
     counter->set(0);
-    std::thread inc_thread2(increment_counter, counter.get(), iterations * 2);
-    std::thread dec_thread2(decrement_counter, counter.get(), iterations);
+    run_threads(counter, threads, thread_iterations * 2, thread_iterations);
+    TEST_EQ(threads / 2 * thread_iterations, counter->get(),
+            "unequal inc/dec");
+
+    // Test 3: values beyond 32 bits, for the counters that have them
+    if constexpr (Counter::value_bits > 32) {
+        std::cout << "\n#3: Wide values\n\n";
+        const int64_t int_max = 2147483647;
+        counter->set(int_max);
+        TEST_EQ(int_max, counter->increment(), "increment() at INT_MAX");
+        TEST_EQ(int_max + 1, counter->get(), "no wrap at INT_MAX");
+        counter->set(-int_max - 1);
+        counter->decrement();
+        TEST_EQ(-int_max - 2, counter->get(), "no wrap at INT_MIN");
+        counter->set(int64_t(1) << 40);
+        TEST_EQ(int64_t(1) << 40, counter->get(), "set(1 << 40)");
+    } else {
+        std::cout << "\n#3: Wrap-around\n\n";
+        const int64_t int_max = 2147483647;
+        counter->set(int_max);
+        TEST_EQ(int_max, counter->increment(), "increment() at INT_MAX");
+        TEST_EQ(-int_max - 1, counter->get(), "wrap at INT_MAX");
+        TEST_EQ(-int_max - 1, counter->decrement(), "decrement() at INT_MIN");
+        TEST_EQ(int_max, counter->get(), "wrap at INT_MIN");
+    }
+    if constexpr (Counter::value_bits == 128) {
+        // One update per set(), increment() and decrement() above
+        const uint64_t epoch = counter->epoch();
+        counter->increment();
+        counter->decrement();
+        TEST_EQ(epoch + 2, counter->epoch(), "epoch counts updates");
+    }
+
+    std::cout << "All " << name << " tests finished successfully!\n\n";
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    // Check if the user has given us an argument
+    if (argc < 2 || argc > 4) {
+        usage(argv);
+        return -1;
+    }
 
-    inc_thread2.join();
-    dec_thread2.join();
-    TEST_EQ(iterations, counter->get(), "unequal inc/dec");
+    const int threads = argc >= 3 ? atoi(argv[2]) : 2;
+    if (threads < 2 || threads > MAX_THREADS || threads % 2 != 0) {
+        std::cerr << "Invalid [THREADS] " << argv[2] << "\n";
+        usage(argv);
+        return -1;
+    }
+
+    const int iterations = argc == 4 ? atoi(argv[3]) : default_iterations;
+    if (iterations < threads / 2) {
+        std::cerr << "Invalid [ITERATIONS] " << argv[3] << "\n";
+        usage(argv);
+        return -1;
+    }
+
+    // Find what that argument was and run the tests with that counter
+    int result = 0;
+    if (!atomic_counter_visit(argv[1], [&](auto &counter) {
+            result = run_tests(&counter, argv[1], threads, iterations);
+        })) {
+        std::cerr << "Invalid <TEST> " << argv[1] << "\n";
+        usage(argv);
+        return -1;
+    }
 
-    std::cout << "All " << argv[1] << " tests finished successfully!\n\n";
+    return result;
 }
@@ -0,0 +1,233 @@
+#include "atomic_counters.hpp"
+#include "linearizability.hpp"
+#include "user_locks.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Stress test that records the history of every operation and checks it for
+// linearizability (see linearizability.hpp) instead of only checking the
+// final value. Counters are checked directly. Locks are checked by
+// incrementing, decrementing and reading a plain int under the lock. Each
+// critical section is then a counter operation, and a mutual exclusion
+// violation shows up as two operations that returned the same prior value.
+//
+// The threads yield or sleep at random points, also while holding a lock, to
+// provoke interleavings that a tight loop rarely hits. The operations and
+// perturbations are drawn from a per-thread generator seeded with [SEED], so
+// a failing run can be repeated with the same schedule of perturbations (the
+// interleaving itself is up to the OS).
+
+void usage(char *argv[]) {
+    std::cerr << "Usage: " << argv[0]
+              << " <KIND> <NAME> [THREADS] [SEED]\n\n"
+              << "Where <KIND> is counter or lock, and <NAME> can be:\n"
+              << "\tcounter:";
+    for (const atomic_counter_info *info = atomic_counter_registry; info->name;
+         ++info) {
+        std::cerr << " " << info->name;
+    }
+    std::cerr << "\n\tlock:";
+    for (const user_lock_info *info = user_lock_registry; info->name; ++info) {
+        std::cerr << " " << info->name;
+    }
+    std::cerr << "\n\n[THREADS] is a number of threads between 1 and "
+              << MAX_THREADS << " (default: 4), [SEED] seeds the\n"
+              << "operations and perturbations (default: 1). nosync and "
+                 "sharded are not\nlinearizable and are expected to fail.\n";
+}
+
+// Every run consists of rounds, each of which is checked on its own, starting
+// from a counter value that is known
+static const int rounds = 20;
+static const int round_ops = 250;
+
+// Chances of a yield and a sleep at every perturbation point, per thousand
+static const unsigned yield_permille = 50;
+static const unsigned sleep_permille = 5;
+static const unsigned max_sleep_us = 50;
+
+struct thread_rng {
+    uint64_t state;
+
+    thread_rng(uint64_t seed, int tid)
+        : state(seed * 0x9e3779b97f4a7c15ull + tid * 0xbf58476d1ce4e5b9ull + 1) {
+    }
+
+    // xorshift64*
+    uint32_t next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return (state * 0x2545f4914f6cdd1dull) >> 32;
+    }
+};
+
+static void perturb(thread_rng &rng) {
+    const unsigned r = rng.next() % 1000;
+    if (r < sleep_permille) {
+        std::this_thread::sleep_for(
+            std::chrono::microseconds(1 + rng.next() % max_sleep_us));
+    } else if (r < sleep_permille + yield_permille) {
+        std::this_thread::yield();
+    }
+}
+
+// 45% increments, 45% decrements and 10% reads
+static counter_op pick_op(thread_rng &rng) {
+    const unsigned r = rng.next() % 100;
+    return r < 45 ? counter_op::increment
+                  : r < 90 ? counter_op::decrement : counter_op::get;
+}
+
+template <typename Counter>
+void counter_thread(Counter *counter, int tid, uint64_t seed,
+                    std::vector<history_op> *history) {
+    thread_rng rng(seed, tid);
+    for (int i = 0; i < round_ops; ++i) {
+        const counter_op op = pick_op(rng);
+        perturb(rng);
+        history_op h = {op, tid, 0, history_now(), 0};
+        if (op == counter_op::increment) {
+            h.result = counter->increment();
+        } else if (op == counter_op::decrement) {
+            h.result = counter->decrement();
+        } else {
+            h.result = counter->get();
+        }
+        h.returned = history_now();
+        history->push_back(h);
+    }
+}
+
+template <typename Lock>
+void lock_thread(Lock *lock, int *value, int tid, uint64_t seed,
+                 std::vector<history_op> *history) {
+    thread_rng rng(seed, tid);
+    for (int i = 0; i < round_ops; ++i) {
+        const counter_op op = pick_op(rng);
+        perturb(rng);
+        history_op h = {op, tid, 0, history_now(), 0};
+        lock->lock(tid);
+        h.result = *value;
+        perturb(rng);
+        if (op == counter_op::increment) {
+            *value = h.result + 1;
+        } else if (op == counter_op::decrement) {
+            *value = h.result - 1;
+        }
+        lock->unlock(tid);
+        h.returned = history_now();
+        history->push_back(h);
+    }
+}
+
+// Runs all rounds. reset(initial) sets the object to the value initial
+// before every round, then the threads of the round call
+// body(tid, round_seed, history) once they have all started.
+template <typename Reset, typename Body>
+int run_rounds(const char *name, int threads, uint64_t seed, Reset &&reset,
+               Body &&body) {
+    std::cout << "\n#1: " << rounds << " rounds of " << round_ops
+              << " operations per thread (" << threads << " threads, seed "
+              << seed << ")\n\n";
+    thread_rng rng(seed, -1);
+    for (int round = 0; round < rounds; ++round) {
+        const int initial = int(rng.next() % 1000);
+        reset(initial);
+        std::vector<std::vector<history_op>> histories(threads);
+        std::atomic<int> started(0);
+        std::vector<std::thread> workers;
+        for (int tid = 0; tid < threads; ++tid) {
+            histories[tid].reserve(round_ops);
+            workers.emplace_back([&, tid]() {
+                started.fetch_add(1);
+                while (started.load() < threads) {
+                    std::this_thread::yield();
+                }
+                body(tid, seed + round, &histories[tid]);
+            });
+        }
+        for (auto &worker : workers) {
+            worker.join();
+        }
+
+        std::vector<history_op> history;
+        for (auto &h : histories) {
+            history.insert(history.end(), h.begin(), h.end());
+        }
+        linearizability_checker checker(history);
+        if (!checker.check(initial)) {
+            std::cout << "linearizable histories: FAILED\n\tRound " << round
+                      << " starting at " << initial << ". ";
+            checker.report(std::cout);
+            return -1;
+        }
+    }
+    std::cout << "linearizable histories: SUCCESS\n";
+    std::cout << "All " << name << " tests finished successfully!\n\n";
+    return 0;
+}
+
+template <typename Counter>
+int run_counter_tests(Counter *counter, const char *name, int threads,
+                      uint64_t seed) {
+    return run_rounds(
+        name, threads, seed, [&](int initial) { counter->set(initial); },
+        [&](int tid, uint64_t round_seed, std::vector<history_op> *history) {
+            counter_thread(counter, tid, round_seed, history);
+        });
+}
+
+template <typename Lock>
+int run_lock_tests(Lock *lock, const char *name, int threads, uint64_t seed) {
+    int value;
+    return run_rounds(
+        name, threads, seed, [&](int initial) { value = initial; },
+        [&](int tid, uint64_t round_seed, std::vector<history_op> *history) {
+            lock_thread(lock, &value, tid, round_seed, history);
+        });
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3 || argc > 5) {
+        usage(argv);
+        return -1;
+    }
+
+    const int threads = argc >= 4 ? atoi(argv[3]) : 4;
+    if (threads < 1 || threads > MAX_THREADS) {
+        std::cerr << "Invalid [THREADS] " << argv[3] << "\n";
+        usage(argv);
+        return -1;
+    }
+    const uint64_t seed = argc == 5 ? strtoull(argv[4], nullptr, 0) : 1;
+
+    int result = 0;
+    bool found;
+    if (strcmp(argv[1], "counter") == 0) {
+        found = atomic_counter_visit(argv[2], [&](auto &counter) {
+            result = run_counter_tests(&counter, argv[2], threads, seed);
+        });
+    } else if (strcmp(argv[1], "lock") == 0) {
+        found = user_lock_visit(argv[2], threads, [&](auto &lock) {
+            result = run_lock_tests(&lock, argv[2], threads, seed);
+        });
+    } else {
+        usage(argv);
+        return -1;
+    }
+    if (!found) {
+        std::cerr << "Invalid <NAME> " << argv[2] << " for " << threads
+                  << " threads\n";
+        usage(argv);
+        return -1;
+    }
+
+    return result;
+}
@@ -0,0 +1,141 @@
+#include "lockfree.hpp"
+#include "test_common.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+void usage(char *argv[]) {
+    std::cerr << "Usage: " << argv[0] << " <STRUCTURE> <RECLAIMER> [THREADS]\n\n"
+              << "Where <STRUCTURE> can be:\n";
+    for (const char *const *name = lockfree_names; *name; ++name) {
+        std::cerr << "\t" << *name << "\n";
+    }
+    std::cerr << "\n<RECLAIMER> can be:\n";
+    for (const char *const *name = reclaimer_names; *name; ++name) {
+        std::cerr << "\t" << *name << "\n";
+    }
+    std::cerr << "\nAnd [THREADS] is an even number of threads between 2 and "
+              << MAX_THREADS << " (default: 2). Half of the threads\n"
+              << "add values and half of the threads remove them.\n";
+}
+
+// Test 1: Single threaded order and empty structure
+template <typename Structure>
+int singlethreaded_tests(Structure &s, const char *name) {
+    std::cout << "\n#1: Singlethreaded tests\n\n";
+    uint64_t v = 0;
+    TEST_EQ(false, take(s, 0, v), "take from empty structure");
+    put(s, 0, 1);
+    put(s, 0, 2);
+    put(s, 0, 3);
+    const bool lifo = strcmp(name, "treiber") == 0;
+    for (uint64_t expected : {lifo ? 3 : 1, 2, lifo ? 1 : 3}) {
+        take(s, 0, v);
+        TEST_EQ(expected, v, "take in " << (lifo ? "LIFO" : "FIFO")
+                                        << " order");
+    }
+    TEST_EQ(false, take(s, 0, v), "take from drained structure");
+
+    return 0;
+}
+
+// Test 2: threads with even ids put unique values, threads with odd ids take
+// them. Every value must be taken exactly once, and no node may be freed
+// while another thread accesses it (run under TSAN to check the latter).
+template <typename Structure>
+int multithreaded_tests(Structure &s, int threads) {
+    std::cout << "\n#2: Multithreaded tests (" << threads << " threads)\n\n";
+    const int iterations = 2000000;
+    const int producers = threads / 2;
+    const uint64_t per_producer = iterations / producers;
+    const uint64_t total = per_producer * producers;
+
+    std::vector<std::atomic<uint8_t>> seen(total);
+    std::atomic<uint64_t> taken(0);
+    std::atomic<uint64_t> duplicates(0);
+    std::vector<std::thread> workers;
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (int tid = 0; tid < threads; ++tid) {
+        workers.emplace_back([&, tid]() {
+            if (tid % 2 == 0) {
+                const uint64_t first = tid / 2 * per_producer;
+                for (uint64_t i = 0; i < per_producer; ++i) {
+                    put(s, tid, first + i);
+                }
+                return;
+            }
+            uint64_t v;
+            while (taken.load(std::memory_order_relaxed) < total) {
+                if (!take(s, tid, v)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                if (v >= total || seen[v].exchange(1)) {
+                    duplicates++;
+                }
+                taken++;
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    auto end_time = std::chrono::high_resolution_clock::now();
+
+    TEST_EQ(total, taken.load(), "values taken");
+    TEST_EQ(0u, duplicates.load(), "values taken twice");
+    uint64_t v;
+    TEST_EQ(false, take(s, 0, v), "structure empty at the end");
+
+    std::chrono::duration<double> total_time = end_time - start_time;
+    const int opss = 2 * total / total_time.count();
+    std::cout << "--> Performance: " << opss << " ops/s\n";
+    std::cout << "--> Retired nodes not yet freed: "
+              << s.reclaimer().pending() << "\n";
+
+    // Every node that was taken has been retired (the queue retires the old
+    // dummy node instead, which is the same number of nodes)
+    s.reclaimer().drain();
+    TEST_EQ(0u, s.reclaimer().pending(), "all retired nodes freed");
+
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    // Check if the user has given us an argument
+    if (argc != 3 && argc != 4) {
+        usage(argv);
+        return -1;
+    }
+
+    const int threads = argc == 4 ? atoi(argv[3]) : 2;
+    if (threads < 2 || threads > MAX_THREADS || threads % 2 != 0) {
+        std::cerr << "Invalid [THREADS] " << argv[3] << "\n";
+        usage(argv);
+        return -1;
+    }
+
+    int result = 0;
+    if (!lockfree_visit(argv[1], argv[2], threads, [&](auto &s) {
+            result = singlethreaded_tests(s, argv[1]);
+            if (result == 0) {
+                result = multithreaded_tests(s, threads);
+            }
+        })) {
+        std::cerr << "Invalid <STRUCTURE> " << argv[1] << " or <RECLAIMER> "
+                  << argv[2] << "\n";
+        usage(argv);
+        return -1;
+    }
+    if (result == 0) {
+        std::cout << "All " << argv[1] << " " << argv[2]
+                  << " tests finished successfully!\n\n";
+    }
+
+    return result;
+}
@@ -0,0 +1,116 @@
+#include "seqlock.hpp"
+#include "test_common.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+void usage(char *argv[]) {
+    std::cerr << "Usage: " << argv[0] << " <LOCK> [THREADS]\n\n"
+              << "Tests a seqlock that uses <LOCK> as its writer lock. Where "
+                 "<LOCK> can be:\n";
+    for (const user_lock_info *info = user_lock_registry; info->name; ++info) {
+        std::cerr << "\t" << info->name;
+        if (info->max_threads) {
+            std::cerr << " (up to " << info->max_threads << " threads)";
+        }
+        std::cerr << "\n";
+    }
+    std::cerr << "\nAnd [THREADS] is a number of threads between 1 and "
+              << MAX_THREADS << " (default: 4).\n";
+}
+
+// Data protected by the seqlock. Writers keep the values equal, a read that
+// returns different values has seen a concurrent write and should have been
+// retried.
+struct shared_data {
+    long a;
+    long b;
+    long c;
+};
+
+// Every write_interval:th operation of a thread is a write
+static const int write_interval = 8;
+
+template <typename Lock>
+void run_thread(seqlock<Lock> *sl, seqlock_data<shared_data> *data, int tid,
+                int iterations, long *torn_reads) {
+    long torn = 0;
+    for (int i = 0; i < iterations; ++i) {
+        if (i % write_interval == 0) {
+            sl->write_lock(tid);
+            shared_data d = data->load();
+            d.a += 1;
+            d.b += 1;
+            d.c += 1;
+            data->store(d);
+            sl->write_unlock(tid);
+        } else {
+            const shared_data d = sl->read([&]() { return data->load(); });
+            if (d.a != d.b || d.b != d.c) {
+                ++torn;
+            }
+        }
+    }
+    *torn_reads = torn;
+}
+
+template <typename Lock>
+int run_tests(Lock *lock, const char *name, int threads) {
+    std::cout << "\n#1: Mixed readers and writers (" << threads
+              << " threads)\n\n";
+    const int iterations = 4000000;
+    const int thread_iterations = iterations / threads;
+    seqlock<Lock> sl(*lock);
+    seqlock_data<shared_data> data({0, 0, 0});
+    std::vector<long> torn_reads(threads);
+    std::vector<std::thread> workers;
+    for (int tid = 0; tid < threads; ++tid) {
+        workers.emplace_back(run_thread<Lock>, &sl, &data, tid,
+                             thread_iterations, &torn_reads[tid]);
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    long torn = 0;
+    for (long t : torn_reads) {
+        torn += t;
+    }
+    TEST_EQ(0, torn, "no torn reads");
+    const long writes =
+        long(threads) *
+        ((thread_iterations + write_interval - 1) / write_interval);
+    TEST_EQ(writes, data.load().a, "no lost writes");
+
+    std::cout << "All seqlock " << name << " tests finished successfully!\n\n";
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    // Check if the user has given us an argument
+    if (argc != 2 && argc != 3) {
+        usage(argv);
+        return -1;
+    }
+
+    const int threads = argc == 3 ? atoi(argv[2]) : 4;
+    if (threads < 1 || threads > MAX_THREADS) {
+        std::cerr << "Invalid [THREADS] " << argv[2] << "\n";
+        usage(argv);
+        return -1;
+    }
+
+    int result = 0;
+    if (!user_lock_visit(argv[1], threads, [&](auto &lock) {
+            result = run_tests(&lock, argv[1], threads);
+        })) {
+        std::cerr << "Invalid <LOCK> " << argv[1] << " for " << threads
+                  << " threads\n";
+        usage(argv);
+        return -1;
+    }
+
+    return result;
+}
@@ -0,0 +1,106 @@
+#include "test_common.hpp"
+#include "user_barriers.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+void usage(char *argv[]) {
+    std::cerr << "Usage: " << argv[0] << " <TEST> [THREADS]\n\n"
+              << "Where <TEST> can be:\n";
+    for (const user_barrier_info *info = user_barrier_registry; info->name;
+         ++info) {
+        std::cerr << "\t" << info->name << "\n";
+    }
+    std::cerr << "\nAnd [THREADS] is a number of threads between 1 and "
+              << MAX_THREADS << " (default: 4).\n";
+}
+
+// Every episode has two phases, like the iterations of the Gauss-Seidel
+// kernel: every thread writes its own slot, waits, reads the slot of its
+// neighbour and waits again before the slots are overwritten. The slots are
+// plain ints, only the barrier orders the accesses (TSAN=1 checks that).
+static const int episodes = 20000;
+
+// Every late_interval:th episode one thread arrives late, so that the others
+// wait long enough to park
+static const int late_interval = 256;
+static const int late_us = 200;
+
+struct alignas(CACHE_LINE_SIZE) slot {
+    int value;
+};
+
+template <typename Barrier>
+void run_thread(Barrier *barrier, int tid, int threads, slot *slots,
+                long *stale_reads) {
+    long stale = 0;
+    for (int e = 1; e <= episodes; ++e) {
+        if (e % late_interval == 0 && e / late_interval % threads == tid) {
+            std::this_thread::sleep_for(std::chrono::microseconds(late_us));
+        }
+        slots[tid].value = e;
+        barrier->wait(tid);
+        if (slots[(tid + 1) % threads].value != e) {
+            ++stale;
+        }
+        barrier->wait(tid);
+    }
+    *stale_reads = stale;
+}
+
+template <typename Barrier>
+int run_tests(Barrier *barrier, const char *name, int threads) {
+    std::cout << "\n#1: " << episodes << " episodes of two phases ("
+              << threads << " threads)\n\n";
+    std::vector<slot> slots(threads, slot{0});
+    std::vector<long> stale_reads(threads);
+    std::vector<std::thread> workers;
+    for (int tid = 0; tid < threads; ++tid) {
+        workers.emplace_back(run_thread<Barrier>, barrier, tid, threads,
+                             slots.data(), &stale_reads[tid]);
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    long stale = 0;
+    for (long s : stale_reads) {
+        stale += s;
+    }
+    TEST_EQ(0, stale, "no thread passes the barrier early");
+    for (int tid = 0; tid < threads; ++tid) {
+        TEST_EQ(episodes, slots[tid].value, "all episodes completed");
+    }
+
+    std::cout << "All " << name << " tests finished successfully!\n\n";
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    // Check if the user has given us an argument
+    if (argc != 2 && argc != 3) {
+        usage(argv);
+        return -1;
+    }
+
+    const int threads = argc == 3 ? atoi(argv[2]) : 4;
+    if (threads < 1 || threads > MAX_THREADS) {
+        std::cerr << "Invalid [THREADS] " << argv[2] << "\n";
+        usage(argv);
+        return -1;
+    }
+
+    int result = 0;
+    if (!user_barrier_visit(argv[1], threads, [&](auto &barrier) {
+            result = run_tests(&barrier, argv[1], threads);
+        })) {
+        std::cerr << "Invalid <TEST> " << argv[1] << "\n";
+        usage(argv);
+        return -1;
+    }
+
+    return result;
+}
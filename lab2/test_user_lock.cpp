@@ -1,20 +1,39 @@
 #include "test_common.hpp"
 #include "user_locks.hpp"
 
+#include <algorithm>
 #include <chrono>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <thread>
+#include <vector>
+
+const int default_iterations = 50000000;
 
 void usage(char *argv[]) {
-    std::cerr << "Usage: " << argv[0] << " <TEST>\n\n"
-              << "Where <TEST> can be:\n"
-              << "\tmutex\n"
-              << "\tdekker\n"
-              << "\tclh\n";
+    std::cerr << "Usage: " << argv[0] << " <TEST> [THREADS] [ITERATIONS]\n\n"
+              << "Where <TEST> can be:\n";
+    for (const user_lock_info *info = user_lock_registry; info->name; ++info) {
+        std::cerr << "\t" << info->name;
+        if (info->max_threads) {
+            std::cerr << " (up to " << info->max_threads << " threads)";
+        }
+        std::cerr << "\n";
+    }
+    std::cerr << "\nAnd [THREADS] is an even number of threads between 2 and "
+              << MAX_THREADS << " (default: 2). Half of the threads\n"
+              << "increment and half of the threads decrement.\n"
+              << "[ITERATIONS] is the number of increments and decrements "
+              << "(default: " << default_iterations << "),\n"
+              << "lower it for locks that are slow when oversubscribed.\n";
 }
 
-void increment_value(user_lock *lock, int tid, int *v, int iterations) {
+// The test loops are templated on the lock type, so that the lock operations
+// can be inlined into them (see user_lock_visit()).
+
+template <typename Lock>
+void increment_value(Lock *lock, int tid, int *v, int iterations) {
     for (int i = 0; i < iterations; ++i) {
         lock->lock(tid);
         *v += 1;
@@ -22,7 +41,8 @@ void increment_value(user_lock *lock, int tid, int *v, int iterations) {
     }
 }
 
-void decrement_value(user_lock *lock, int tid, int *v, int iterations) {
+template <typename Lock>
+void decrement_value(Lock *lock, int tid, int *v, int iterations) {
     for (int i = 0; i < iterations; ++i) {
         lock->lock(tid);
         *v -= 1;
@@ -30,51 +50,97 @@ void decrement_value(user_lock *lock, int tid, int *v, int iterations) {
     }
 }
 
-int main(int argc, char *argv[]) {
-    // Check if the user has given us an argument
-    if (argc != 2) {
-        usage(argv);
-        return -1;
+// Runs the increment threads (even thread ids) and decrement threads (odd
+// thread ids) and returns the time at which each thread finished, in seconds
+// since the start of the run.
+template <typename Lock>
+std::vector<double> run_threads(Lock *lock, int threads, int *v,
+                                int inc_iterations, int dec_iterations) {
+    std::vector<std::thread> workers;
+    std::vector<double> finish_time(threads);
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    for (int tid = 0; tid < threads; ++tid) {
+        workers.emplace_back([=, &finish_time]() {
+            if (tid % 2 == 0) {
+                increment_value(lock, tid, v, inc_iterations);
+            } else {
+                decrement_value(lock, tid, v, dec_iterations);
+            }
+            std::chrono::duration<double> t =
+                std::chrono::high_resolution_clock::now() - start_time;
+            finish_time[tid] = t.count();
+        });
     }
 
-    // Find what that argument was and initialize the appropriate test
-    std::unique_ptr<user_lock> lock = nullptr;
-    if (strcmp(argv[1], "mutex") == 0) {
-        lock.reset(new user_lock_mutex());
-    } else if (strcmp(argv[1], "dekker") == 0) {
-        lock.reset(new user_lock_dekker());
-    } else if (strcmp(argv[1], "clh") == 0) {
-        lock.reset(new user_lock_clh());
-    } else {
-        std::cerr << "Invalid <TEST> " << argv[1] << "\n";
-        usage(argv);
-        return -1;
+    for (auto &worker : workers) {
+        worker.join();
     }
 
+    return finish_time;
+}
+
+template <typename Lock>
+int run_tests(Lock *lock, const char *name, int threads, int iterations) {
     // Test 1: multithreaded increment and decrement
-    std::cout << "\n#1: Multithreaded tests\n\n";
-    const int iterations = 50000000;
+    std::cout << "\n#1: Multithreaded tests (" << threads << " threads)\n\n";
+    // Every thread does an equal share of the work of the two thread test
+    const int thread_iterations = iterations / (threads / 2);
     int value = 0;
-    auto start_time = std::chrono::high_resolution_clock::now();
-    std::thread inc_thread(increment_value, lock.get(), 0, &value, iterations);
-    std::thread dec_thread(decrement_value, lock.get(), 1, &value, iterations);
-
-    inc_thread.join();
-    dec_thread.join();
-    auto end_time = std::chrono::high_resolution_clock::now();
+    auto finish_time = run_threads(lock, threads, &value, thread_iterations,
+                                   thread_iterations);
     TEST_EQ(0, value, "equal inc/dec");
-    std::chrono::duration<double> total_time = end_time - start_time;
-    const int opss = iterations / total_time.count();
+    const double total_time =
+        *std::max_element(finish_time.begin(), finish_time.end());
+    const double first_done =
+        *std::min_element(finish_time.begin(), finish_time.end());
+    const int opss = iterations / total_time;
     std::cout << "--> Performance: " << opss << " ops/s\n";
+    // All threads do the same amount of work, with a fair lock they all
+    // finish at about the same time.
+    std::cout << "--> Fairness: " << first_done / total_time
+              << " (first/last thread finish time)\n";
 
     value = 0;
-    std::thread inc_thread2(increment_value, lock.get(), 0, &value,
-                            iterations * 2);
-    std::thread dec_thread2(decrement_value, lock.get(), 1, &value, iterations);
+    run_threads(lock, threads, &value, thread_iterations * 2,
+                thread_iterations);
+    TEST_EQ(threads / 2 * thread_iterations, value, "unequal inc/dec");
+
+    std::cout << "All " << name << " tests finished successfully!\n\n";
+    return 0;
+}
 
-    inc_thread2.join();
-    dec_thread2.join();
-    TEST_EQ(iterations, value, "unequal inc/dec");
+int main(int argc, char *argv[]) {
+    // Check if the user has given us an argument
+    if (argc < 2 || argc > 4) {
+        usage(argv);
+        return -1;
+    }
+
+    const int threads = argc >= 3 ? atoi(argv[2]) : 2;
+    if (threads < 2 || threads > MAX_THREADS || threads % 2 != 0) {
+        std::cerr << "Invalid [THREADS] " << argv[2] << "\n";
+        usage(argv);
+        return -1;
+    }
+
+    const int iterations = argc == 4 ? atoi(argv[3]) : default_iterations;
+    if (iterations < threads / 2) {
+        std::cerr << "Invalid [ITERATIONS] " << argv[3] << "\n";
+        usage(argv);
+        return -1;
+    }
+
+    // Find what that argument was and run the tests with that lock
+    int result = 0;
+    if (!user_lock_visit(argv[1], threads, [&](auto &lock) {
+            result = run_tests(&lock, argv[1], threads, iterations);
+        })) {
+        std::cerr << "Invalid <TEST> " << argv[1] << " for " << threads
+                  << " threads\n";
+        usage(argv);
+        return -1;
+    }
 
-    std::cout << "All " << argv[1] << " tests finished successfully!\n\n";
+    return result;
 }
@@ -0,0 +1,122 @@
+#include "test_common.hpp"
+#include "user_rwlocks.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+const int default_iterations = 4000000;
+
+void usage(char *argv[]) {
+    std::cerr << "Usage: " << argv[0] << " <TEST> [THREADS] [ITERATIONS]\n\n"
+              << "Where <TEST> can be:\n";
+    for (const user_rwlock_info *info = user_rwlock_registry; info->name;
+         ++info) {
+        std::cerr << "\t" << info->name;
+        if (info->max_threads) {
+            std::cerr << " (up to " << info->max_threads << " threads)";
+        }
+        std::cerr << "\n";
+    }
+    std::cerr << "\nAnd [THREADS] is a number of threads between 1 and "
+              << MAX_THREADS << " (default: 4).\n"
+              << "[ITERATIONS] is the total number of lock operations "
+              << "(default: " << default_iterations << "),\n"
+              << "lower it for locks that are slow when oversubscribed.\n";
+}
+
+// Data protected by the lock. Writers keep the two values equal, a reader that
+// sees them differ has run concurrently with a writer.
+struct shared_data {
+    long a;
+    long b;
+};
+
+// Every write_interval:th operation of a thread is a write
+static const int write_interval = 8;
+
+template <typename Lock>
+void run_thread(Lock *lock, int tid, shared_data *data, int iterations,
+                long *torn_reads) {
+    long torn = 0;
+    for (int i = 0; i < iterations; ++i) {
+        if (i % write_interval == 0) {
+            lock->lock(tid);
+            data->a += 1;
+            data->b += 1;
+            lock->unlock(tid);
+        } else {
+            lock->lock_shared(tid);
+            if (data->a != data->b) {
+                ++torn;
+            }
+            lock->unlock_shared(tid);
+        }
+    }
+    *torn_reads = torn;
+}
+
+template <typename Lock>
+int run_tests(Lock *lock, const char *name, int threads, int iterations) {
+    std::cout << "\n#1: Mixed readers and writers (" << threads
+              << " threads)\n\n";
+    const int thread_iterations = iterations / threads;
+    shared_data data = {0, 0};
+    std::vector<long> torn_reads(threads);
+    std::vector<std::thread> workers;
+    for (int tid = 0; tid < threads; ++tid) {
+        workers.emplace_back(run_thread<Lock>, lock, tid, &data,
+                             thread_iterations, &torn_reads[tid]);
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    long torn = 0;
+    for (long t : torn_reads) {
+        torn += t;
+    }
+    TEST_EQ(0, torn, "no torn reads");
+    const long writes =
+        long(threads) *
+        ((thread_iterations + write_interval - 1) / write_interval);
+    TEST_EQ(writes, data.a, "no lost writes");
+
+    std::cout << "All " << name << " tests finished successfully!\n\n";
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    // Check if the user has given us an argument
+    if (argc < 2 || argc > 4) {
+        usage(argv);
+        return -1;
+    }
+
+    const int threads = argc >= 3 ? atoi(argv[2]) : 4;
+    if (threads < 1 || threads > MAX_THREADS) {
+        std::cerr << "Invalid [THREADS] " << argv[2] << "\n";
+        usage(argv);
+        return -1;
+    }
+
+    const int iterations = argc == 4 ? atoi(argv[3]) : default_iterations;
+    if (iterations < threads) {
+        std::cerr << "Invalid [ITERATIONS] " << argv[3] << "\n";
+        usage(argv);
+        return -1;
+    }
+
+    int result = 0;
+    if (!user_rwlock_visit(argv[1], threads, [&](auto &lock) {
+            result = run_tests(&lock, argv[1], threads, iterations);
+        })) {
+        std::cerr << "Invalid <TEST> " << argv[1] << " for " << threads
+                  << " threads\n";
+        usage(argv);
+        return -1;
+    }
+
+    return result;
+}
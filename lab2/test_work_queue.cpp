@@ -0,0 +1,215 @@
+#include "test_common.hpp"
+#include "work_queues.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+void usage(char *argv[]) {
+    std::cerr << "Usage: " << argv[0] << " <TEST> [PRODUCERS] [CONSUMERS]\n\n"
+              << "Where <TEST> can be:\n";
+    for (const work_queue_info *info = work_queue_registry; info->name;
+         ++info) {
+        std::cerr << "\t" << info->name << "\n";
+    }
+    std::cerr << "\nAnd [PRODUCERS] and [CONSUMERS] are the number of threads "
+              << "that enqueue and\ndequeue (default: 2 each), at most "
+              << MAX_THREADS << " in total.\n";
+}
+
+// Items carry the id of their producer in the upper 32 bits and the
+// producer's sequence number in the lower 32 bits
+static uint64_t make_item(int producer, uint64_t seq) {
+    return uint64_t(producer) << 32 | seq;
+}
+
+// Largest batch used by the tests
+static const size_t max_batch = 8;
+
+// Test 1: Single threaded FIFO order, full and empty queue and batches
+template <typename Queue>
+int singlethreaded_tests(Queue *queue, size_t capacity) {
+    std::cout << "\n#1: Singlethreaded tests\n\n";
+    uint64_t item = 0;
+
+    TEST_EQ(false, queue->try_dequeue(item), "dequeue from empty queue");
+    for (size_t i = 0; i < capacity; ++i) {
+        if (!queue->try_enqueue(i)) {
+            TEST_EQ(capacity, i, "enqueue until full");
+        }
+    }
+    TEST_EQ(false, queue->try_enqueue(capacity), "enqueue to full queue");
+    for (size_t i = 0; i < capacity; ++i) {
+        if (!queue->try_dequeue(item) || item != i) {
+            TEST_EQ(i, item, "dequeue in FIFO order");
+        }
+    }
+    TEST_EQ(false, queue->try_dequeue(item), "dequeue from drained queue");
+
+    // Batches that wrap around the end of the ring
+    std::vector<uint64_t> items(capacity + max_batch);
+    for (size_t i = 0; i < items.size(); ++i) {
+        items[i] = 1000 + i;
+    }
+    TEST_EQ(3u, queue->try_enqueue_batch(items.data(), 3), "enqueue batch");
+    TEST_EQ(capacity - 3,
+            queue->try_enqueue_batch(items.data() + 3, items.size() - 3),
+            "enqueue batch larger than the free space");
+    TEST_EQ(0u, queue->try_enqueue_batch(items.data(), 1),
+            "enqueue batch to full queue");
+
+    std::vector<uint64_t> out(capacity + max_batch);
+    TEST_EQ(5u, queue->try_dequeue_batch(out.data(), 5), "dequeue batch");
+    TEST_EQ(capacity - 5, queue->try_dequeue_batch(out.data() + 5, out.size()),
+            "dequeue batch larger than the queue");
+    TEST_EQ(true, std::equal(out.begin(), out.begin() + capacity,
+                             items.begin()),
+            "batches in FIFO order");
+    TEST_EQ(0u, queue->try_dequeue_batch(out.data(), 1),
+            "dequeue batch from empty queue");
+
+    return 0;
+}
+
+// Test 2: producers and consumers. Every item must be dequeued exactly once,
+// and every consumer must see the items of a producer in the order in which
+// they were enqueued. Odd iterations use the batch operations.
+template <typename Queue>
+int multithreaded_tests(Queue *queue, int producers, int consumers) {
+    std::cout << "\n#2: Multithreaded tests (" << producers << " producers, "
+              << consumers << " consumers)\n\n";
+    const int iterations = 4000000;
+    const uint64_t per_producer = iterations / producers;
+    const uint64_t total = per_producer * producers;
+
+    std::vector<std::atomic<uint8_t>> seen(total);
+    std::atomic<uint64_t> dequeued(0);
+    std::atomic<uint64_t> duplicates(0);
+    std::atomic<uint64_t> out_of_order(0);
+    std::vector<std::thread> workers;
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (int p = 0; p < producers; ++p) {
+        workers.emplace_back([=]() {
+            uint64_t batch[max_batch];
+            for (uint64_t seq = 0, i = 0; seq < per_producer; ++i) {
+                const size_t n = std::min<uint64_t>(
+                    i % 2 ? 1 + i % max_batch : 1, per_producer - seq);
+                for (size_t k = 0; k < n; ++k) {
+                    batch[k] = make_item(p, seq + k);
+                }
+                size_t done = 0;
+                while (done < n) {
+                    const size_t m =
+                        n == 1 ? queue->try_enqueue(batch[0])
+                               : queue->try_enqueue_batch(batch + done,
+                                                          n - done);
+                    if (!m) {
+                        std::this_thread::yield();
+                    }
+                    done += m;
+                }
+                seq += n;
+            }
+        });
+    }
+    for (int c = 0; c < consumers; ++c) {
+        workers.emplace_back([&, c]() {
+            std::vector<int64_t> last(producers, -1);
+            uint64_t batch[max_batch];
+            for (uint64_t i = c; dequeued.load() < total; ++i) {
+                const size_t n =
+                    i % 2 ? queue->try_dequeue_batch(batch, 1 + i % max_batch)
+                          : queue->try_dequeue(batch[0]);
+                if (!n) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                for (size_t k = 0; k < n; ++k) {
+                    const int p = batch[k] >> 32;
+                    const int64_t seq = batch[k] & 0xffffffff;
+                    if (seq <= last[p]) {
+                        out_of_order++;
+                    }
+                    last[p] = seq;
+                    if (seen[p * per_producer + seq].exchange(1)) {
+                        duplicates++;
+                    }
+                }
+                dequeued += n;
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    auto end_time = std::chrono::high_resolution_clock::now();
+
+    TEST_EQ(total, dequeued.load(), "items dequeued");
+    TEST_EQ(0u, duplicates.load(), "items dequeued twice");
+    TEST_EQ(0u, out_of_order.load(), "items of a producer out of order");
+    uint64_t missing = 0;
+    for (auto &s : seen) {
+        missing += !s.load();
+    }
+    TEST_EQ(0u, missing, "items lost");
+    uint64_t item;
+    TEST_EQ(false, queue->try_dequeue(item), "queue empty at the end");
+
+    std::chrono::duration<double> total_time = end_time - start_time;
+    const int opss = total / total_time.count();
+    std::cout << "--> Performance: " << opss << " items/s\n";
+
+    return 0;
+}
+
+template <typename Queue>
+int run_tests(Queue *queue, const char *name, size_t capacity, int producers,
+              int consumers) {
+    int result = singlethreaded_tests(queue, capacity);
+    if (result != 0) {
+        return result;
+    }
+    result = multithreaded_tests(queue, producers, consumers);
+    if (result != 0) {
+        return result;
+    }
+
+    std::cout << "All " << name << " tests finished successfully!\n\n";
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    // Check if the user has given us an argument
+    if (argc < 2 || argc > 4) {
+        usage(argv);
+        return -1;
+    }
+
+    const int producers = argc >= 3 ? atoi(argv[2]) : 2;
+    const int consumers = argc >= 4 ? atoi(argv[3]) : 2;
+    if (producers < 1 || consumers < 1 ||
+        producers + consumers > MAX_THREADS) {
+        std::cerr << "Invalid [PRODUCERS] or [CONSUMERS]\n";
+        usage(argv);
+        return -1;
+    }
+
+    // A small queue, so that the multithreaded test often finds it full
+    const size_t capacity = 64;
+    int result = 0;
+    if (!work_queue_visit(argv[1], capacity, [&](auto &queue) {
+            result =
+                run_tests(&queue, argv[1], capacity, producers, consumers);
+        })) {
+        std::cerr << "Invalid <TEST> " << argv[1] << "\n";
+        usage(argv);
+        return -1;
+    }
+
+    return result;
+}
@@ -0,0 +1,84 @@
+#ifndef TREIBER_STACK_HPP
+#define TREIBER_STACK_HPP
+
+#include "reclamation.hpp"
+
+/*******************************************************************************
+ *                          Treiber's lock-free stack                          *
+ ******************************************************************************/
+
+// Treiber, "Systems Programming: Coping with Parallelism". The stack is a
+// linked list and push/pop swing m_top with a CAS. Popped nodes are retired
+// through the Reclaimer. This also prevents the ABA problem: a node cannot
+// be freed and reallocated while a popping thread has it protected.
+
+template <typename Reclaimer>
+class treiber_stack {
+private:
+    struct node {
+        uint64_t value;
+        // Written before the node is published and never changed, a node is
+        // only pushed once
+        node *next;
+    };
+
+    alignas(CACHE_LINE_SIZE) std::atomic<node *> m_top;
+    Reclaimer m_reclaimer;
+
+public:
+    static constexpr const char *name = "treiber";
+    // Size of the nodes, for memory footprint estimates
+    static const size_t node_size = sizeof(node);
+
+    // max_threads: threads may use the ids 0 to max_threads - 1
+    explicit treiber_stack(int max_threads = MAX_THREADS)
+        : m_top(nullptr)
+        , m_reclaimer(max_threads) {
+    }
+
+    // Not thread safe, no other thread may use the stack
+    ~treiber_stack() {
+        node *n = m_top.load(std::memory_order_relaxed);
+        while (n) {
+            node *next = n->next;
+            delete n;
+            n = next;
+        }
+    }
+
+    void push(int thread_id, uint64_t value) {
+        node *n = new node{value, m_top.load(std::memory_order_relaxed)};
+        m_reclaimer.enter(thread_id);
+        while (!m_top.compare_exchange_weak(n->next, n,
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+        }
+        m_reclaimer.leave(thread_id);
+    }
+
+    // Returns false if the stack is empty
+    bool pop(int thread_id, uint64_t &value) {
+        m_reclaimer.enter(thread_id);
+        for (;;) {
+            node *top = m_reclaimer.protect(thread_id, 0, m_top);
+            if (!top) {
+                m_reclaimer.leave(thread_id);
+                return false;
+            }
+            if (m_top.compare_exchange_weak(top, top->next,
+                                            std::memory_order_acq_rel,
+                                            std::memory_order_relaxed)) {
+                value = top->value;
+                m_reclaimer.retire(thread_id, top);
+                m_reclaimer.leave(thread_id);
+                return true;
+            }
+        }
+    }
+
+    Reclaimer &reclaimer() {
+        return m_reclaimer;
+    }
+};
+
+#endif // TREIBER_STACK_HPP
@@ -0,0 +1,32 @@
+#ifndef USER_BARRIER_CENTRAL_HPP
+#define USER_BARRIER_CENTRAL_HPP
+
+#include "user_barriers.hpp"
+
+template <bool Park>
+inline user_barrier_central<Park>::user_barrier_central(int threads)
+    : user_barrier()
+    , m_threads(threads)
+    , m_count(threads)
+    , m_local_sense(new padded<int>[threads]) {
+    for (int i = 0; i < threads; ++i) {
+        m_local_sense[i].value = 0;
+    }
+}
+
+template <bool Park>
+inline void user_barrier_central<Park>::wait(int thread_id) {
+    const int sense = 1 - m_local_sense[thread_id].value;
+    m_local_sense[thread_id].value = sense;
+
+    if (m_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        // No thread can arrive for the next episode before the sense flips,
+        // so the count can be reset with a plain store
+        m_count.store(m_threads, std::memory_order_relaxed);
+        m_sense.set(sense);
+    } else {
+        m_sense.wait_for(sense);
+    }
+}
+
+#endif // USER_BARRIER_CENTRAL_HPP
@@ -0,0 +1,69 @@
+#ifndef USER_BARRIER_COMBINING_TREE_HPP
+#define USER_BARRIER_COMBINING_TREE_HPP
+
+#include "user_barriers.hpp"
+
+template <bool Park>
+inline user_barrier_combining_tree<Park>::user_barrier_combining_tree(
+    int threads)
+    : user_barrier()
+    , m_local_sense(new padded<int>[threads]) {
+    for (int i = 0; i < threads; ++i) {
+        m_local_sense[i].value = 0;
+    }
+
+    // The nodes are stored level by level, starting with the leaves
+    int nodes = 0;
+    for (int level = threads; level > 1 || nodes == 0;) {
+        level = (level + fan_in - 1) / fan_in;
+        nodes += level;
+    }
+    m_nodes.reset(new node[nodes]);
+
+    int first = 0;
+    int arrivals = threads;
+    for (;;) {
+        const int level = (arrivals + fan_in - 1) / fan_in;
+        for (int i = 0; i < level; ++i) {
+            node &n = m_nodes[first + i];
+            n.fan_in = std::min(fan_in, arrivals - i * fan_in);
+            n.count.store(n.fan_in, std::memory_order_relaxed);
+            n.parent = level == 1 ? -1 : first + level + i / fan_in;
+        }
+        if (level == 1) {
+            break;
+        }
+        first += level;
+        arrivals = level;
+    }
+}
+
+template <bool Park>
+inline bool user_barrier_combining_tree<Park>::arrive(int n) {
+    for (;;) {
+        node &current = m_nodes[n];
+        if (current.count.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+            return false;
+        }
+        // No thread arrives at this node again before the sense flips
+        current.count.store(current.fan_in, std::memory_order_relaxed);
+        if (current.parent < 0) {
+            return true;
+        }
+        n = current.parent;
+    }
+}
+
+template <bool Park>
+inline void user_barrier_combining_tree<Park>::wait(int thread_id) {
+    const int sense = 1 - m_local_sense[thread_id].value;
+    m_local_sense[thread_id].value = sense;
+
+    if (arrive(thread_id / fan_in)) {
+        m_sense.set(sense);
+    } else {
+        m_sense.wait_for(sense);
+    }
+}
+
+#endif // USER_BARRIER_COMBINING_TREE_HPP
@@ -0,0 +1,37 @@
+#ifndef USER_BARRIER_DISSEMINATION_HPP
+#define USER_BARRIER_DISSEMINATION_HPP
+
+#include "user_barriers.hpp"
+
+template <bool Park>
+inline user_barrier_dissemination<Park>::user_barrier_dissemination(
+    int threads)
+    : user_barrier()
+    , m_threads(threads)
+    , m_rounds(0)
+    , m_state(new thread_state[threads]) {
+    while ((1 << m_rounds) < threads) {
+        m_rounds++;
+    }
+    m_flags.reset(new barrier_flag<Park>[threads * 2 * m_rounds]);
+}
+
+template <bool Park>
+inline void user_barrier_dissemination<Park>::wait(int thread_id) {
+    thread_state &s = m_state[thread_id];
+
+    for (int round = 0; round < m_rounds; ++round) {
+        const int partner = (thread_id + (1 << round)) % m_threads;
+        flag(partner, s.parity, round).set(s.sense);
+        flag(thread_id, s.parity, round).wait_for(s.sense);
+    }
+
+    // The flags of a parity are used every other episode, with alternating
+    // values
+    if (s.parity == 1) {
+        s.sense = 1 - s.sense;
+    }
+    s.parity = 1 - s.parity;
+}
+
+#endif // USER_BARRIER_DISSEMINATION_HPP
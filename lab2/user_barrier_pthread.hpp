@@ -0,0 +1,19 @@
+#ifndef USER_BARRIER_PTHREAD_HPP
+#define USER_BARRIER_PTHREAD_HPP
+
+#include "user_barriers.hpp"
+
+inline user_barrier_pthread::user_barrier_pthread(int threads)
+    : user_barrier() {
+    pthread_barrier_init(&m_barrier, nullptr, threads);
+}
+
+inline user_barrier_pthread::~user_barrier_pthread() {
+    pthread_barrier_destroy(&m_barrier);
+}
+
+inline void user_barrier_pthread::wait(int) {
+    pthread_barrier_wait(&m_barrier);
+}
+
+#endif // USER_BARRIER_PTHREAD_HPP
@@ -0,0 +1,31 @@
+#include "user_barriers.hpp"
+
+template <typename Barrier>
+static user_barrier *create_barrier(int threads) {
+    return new Barrier(threads);
+}
+
+template <typename List>
+struct registry_of;
+
+template <typename... Barriers>
+struct registry_of<user_barrier_list<Barriers...>> {
+    static constexpr user_barrier_info entries[] = {
+        {Barriers::name, create_barrier<Barriers>}...,
+        {nullptr, nullptr},
+    };
+};
+
+const user_barrier_info *const user_barrier_registry =
+    registry_of<user_barrier_types>::entries;
+
+user_barrier *user_barrier_create(const char *name, int threads) {
+    for (const user_barrier_info *info = user_barrier_registry; info->name;
+         ++info) {
+        if (strcmp(info->name, name) == 0) {
+            return info->create(threads);
+        }
+    }
+
+    return nullptr;
+}
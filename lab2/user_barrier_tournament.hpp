@@ -0,0 +1,41 @@
+#ifndef USER_BARRIER_TOURNAMENT_HPP
+#define USER_BARRIER_TOURNAMENT_HPP
+
+#include "user_barriers.hpp"
+
+template <bool Park>
+inline user_barrier_tournament<Park>::user_barrier_tournament(int threads)
+    : user_barrier()
+    , m_threads(threads)
+    , m_state(new thread_state[threads]) {
+}
+
+template <bool Park>
+inline void user_barrier_tournament<Park>::wait(int thread_id) {
+    thread_state &s = m_state[thread_id];
+    const int sense = 1 - s.sense;
+    s.sense = sense;
+
+    // Arrival: in round k (the distance to the opponent), a thread with bit
+    // k set in its id loses
+    int k = 1;
+    for (; k < m_threads; k <<= 1) {
+        if (thread_id & k) {
+            s.arrived.set(sense);
+            s.wakeup.wait_for(sense);
+            break;
+        }
+        if (thread_id + k < m_threads) {
+            m_state[thread_id + k].arrived.wait_for(sense);
+        }
+    }
+
+    // Wakeup: the threads this one has beaten, from the last round down
+    for (k >>= 1; k > 0; k >>= 1) {
+        if (thread_id + k < m_threads) {
+            m_state[thread_id + k].wakeup.set(sense);
+        }
+    }
+}
+
+#endif // USER_BARRIER_TOURNAMENT_HPP
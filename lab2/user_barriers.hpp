@@ -0,0 +1,349 @@
+#ifndef USER_BARRIERS_HPP
+#define USER_BARRIERS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+#include <pthread.h>
+
+#include "sync_common.hpp"
+
+/*******************************************************************************
+ *                              Base Barrier Class                             *
+ ******************************************************************************/
+
+// Barriers for a fixed number of threads, which they are created for. Like
+// the locks, the barriers derive from user_barrier so that they can be
+// selected at runtime (see user_barrier_create()), and are final and
+// implemented in headers so that code that knows the concrete type can
+// inline them (see user_barrier_visit()).
+//
+// Apart from pthread, every barrier comes in two variants: one that spins
+// until the barrier opens, and one (*_park) that spins for a while and then
+// sleeps on a futex. Spinning has the lowest latency when every thread has a
+// CPU of its own, parking wastes no CPU time when the threads are
+// oversubscribed or arrive far apart.
+
+class user_barrier {
+public:
+    /**
+     * Waits until all threads have called wait() in this episode. The
+     * barrier can be used again right away, for the next episode.
+     *
+     * Arguments:
+     *	thread_id: The id of the calling thread, between 0 and the number of
+     *	threads the barrier was created for - 1. Every thread uses its own id.
+     */
+    virtual void wait(int thread_id) = 0;
+
+    virtual ~user_barrier(){};
+};
+
+/*******************************************************************************
+ *                               Barrier registry                              *
+ ******************************************************************************/
+
+struct user_barrier_info {
+    // Name used to select the barrier in the tests and benchmarks
+    const char *name;
+    // Creates a barrier for the threads with the ids 0 to threads - 1
+    user_barrier *(*create)(int threads);
+};
+
+// All available barriers, terminated by an entry with name == nullptr
+extern const user_barrier_info *const user_barrier_registry;
+
+/**
+ * This function creates a barrier by name. E.g.:
+ *
+ * std::unique_ptr<user_barrier> barrier(user_barrier_create("central", 4));
+ *
+ * Arguments:
+ *	name: The name of the barrier in user_barrier_registry.
+ *	threads: The number of threads that will wait on the barrier.
+ *
+ * Returns:
+ *	The new barrier, or nullptr if there is no barrier with that name.
+ */
+user_barrier *user_barrier_create(const char *name, int threads);
+
+/*******************************************************************************
+ *                                Waiting flags                                *
+ ******************************************************************************/
+
+// A word that threads wait for to take a given value. Every barrier waits on
+// flags of this type, which are padded so that a waiter spins on a cache
+// line of its own (or one shared only with the threads waiting for the same
+// event).
+//
+// With Park, a waiter that has spun for park_spins iterations registers in
+// m_parked and sleeps on a futex, and set() wakes the sleepers. The waiter
+// registers before it checks the value for the last time and set() checks
+// m_parked after it has changed the value, both seq_cst, so that either the
+// waiter sees the new value or set() sees the waiter.
+//
+// There is no backoff policy (see backoff.hpp): a flag is written once per
+// episode and its waiters only read it, so there is no contention that
+// backing off would reduce, it would only delay the wakeup.
+template <bool Park>
+struct alignas(CACHE_LINE_SIZE) barrier_flag {
+    static const int park_spins = 2000;
+
+    std::atomic<int> m_value{0};
+    std::atomic<int> m_parked{0};
+
+    void set(int value) {
+        if constexpr (Park) {
+            m_value.store(value, std::memory_order_seq_cst);
+            if (m_parked.load(std::memory_order_seq_cst) != 0) {
+                futex_syscall(&m_value, FUTEX_WAKE, INT_MAX);
+            }
+        } else {
+            m_value.store(value, std::memory_order_release);
+        }
+    }
+
+    void wait_for(int value) {
+        for (int spins = 0;
+             m_value.load(std::memory_order_acquire) != value; ++spins) {
+            if (Park && spins >= park_spins) {
+                park(value);
+                return;
+            }
+            cpu_relax();
+        }
+    }
+
+private:
+    void park(int value) {
+        m_parked.fetch_add(1, std::memory_order_seq_cst);
+        for (;;) {
+            const int current = m_value.load(std::memory_order_seq_cst);
+            if (current == value) {
+                break;
+            }
+            futex_syscall(&m_value, FUTEX_WAIT, current);
+        }
+        m_parked.fetch_sub(1, std::memory_order_relaxed);
+    }
+};
+
+/*******************************************************************************
+ *                             pthread_barrier_t                               *
+ ******************************************************************************/
+
+// Baseline: the barrier used by the kernels so far
+
+class user_barrier_pthread final : public user_barrier {
+private:
+    pthread_barrier_t m_barrier;
+
+public:
+    static constexpr const char *name = "pthread";
+
+    explicit user_barrier_pthread(int threads);
+    ~user_barrier_pthread() override;
+
+    void wait(int thread_id) override;
+};
+
+/*******************************************************************************
+ *                       Centralized sense-reversing barrier                   *
+ ******************************************************************************/
+
+// All threads decrement a shared count, the last one to arrive resets it and
+// flips a global sense flag that the others spin on. Every thread keeps its
+// own sense, which alternates between episodes, so the barrier can be reused
+// without waiting for the threads of the previous episode to leave.
+
+template <bool Park>
+class user_barrier_central final : public user_barrier {
+private:
+    const int m_threads;
+    alignas(CACHE_LINE_SIZE) std::atomic<int> m_count;
+    barrier_flag<Park> m_sense;
+    std::unique_ptr<padded<int>[]> m_local_sense;
+
+public:
+    static constexpr const char *name = Park ? "central_park" : "central";
+
+    explicit user_barrier_central(int threads);
+
+    void wait(int thread_id) override;
+};
+
+/*******************************************************************************
+ *                             Dissemination barrier                           *
+ ******************************************************************************/
+
+// Hensgen, Finkel and Manber; Mellor-Crummey and Scott, "Algorithms for
+// scalable synchronization on shared-memory multiprocessors", 1991. In round
+// r every thread signals the thread 2^r ahead of it and waits for the signal
+// of the thread 2^r behind it. After ceil(log2(threads)) rounds every thread
+// has transitively heard from all others. There is no shared counter, every
+// flag has one writer and one reader. The flags alternate between two sets
+// (parity), and their values between episodes (sense), so that they never
+// have to be reset.
+
+template <bool Park>
+class user_barrier_dissemination final : public user_barrier {
+private:
+    struct alignas(CACHE_LINE_SIZE) thread_state {
+        int parity = 0;
+        int sense = 1;
+    };
+
+    const int m_threads;
+    int m_rounds;
+    std::unique_ptr<thread_state[]> m_state;
+    // The flag of thread t for parity p and round r is
+    // m_flags[(t * 2 + p) * m_rounds + r]
+    std::unique_ptr<barrier_flag<Park>[]> m_flags;
+
+    barrier_flag<Park> &flag(int thread_id, int parity, int round) {
+        return m_flags[(thread_id * 2 + parity) * m_rounds + round];
+    }
+
+public:
+    static constexpr const char *name =
+        Park ? "dissemination_park" : "dissemination";
+
+    explicit user_barrier_dissemination(int threads);
+
+    void wait(int thread_id) override;
+};
+
+/*******************************************************************************
+ *                              Tournament barrier                             *
+ ******************************************************************************/
+
+// Mellor-Crummey and Scott's tournament barrier with statically chosen
+// winners. In round k the thread with an id that is a multiple of 2^(k+1)
+// wins against the thread 2^k above it: the loser signals its arrival and
+// drops out, the winner waits for that signal and goes on to the next round.
+// Thread 0 wins the tournament and starts the wakeup, which runs down the
+// same tree: every winner wakes the threads it has beaten, latest round
+// first. Each thread spins only on its own flags.
+
+template <bool Park>
+class user_barrier_tournament final : public user_barrier {
+private:
+    struct alignas(CACHE_LINE_SIZE) thread_state {
+        // Set by the thread when it loses, waited for by its winner
+        barrier_flag<Park> arrived;
+        // Set by the winner, waited for by the thread after it has lost
+        barrier_flag<Park> wakeup;
+        int sense = 0;
+    };
+
+    const int m_threads;
+    std::unique_ptr<thread_state[]> m_state;
+
+public:
+    static constexpr const char *name = Park ? "tournament_park" : "tournament";
+
+    explicit user_barrier_tournament(int threads);
+
+    void wait(int thread_id) override;
+};
+
+/*******************************************************************************
+ *                            Combining tree barrier                           *
+ ******************************************************************************/
+
+// Yew, Tzeng and Lawrie, "Distributing hot-spot addressing in large-scale
+// multiprocessors", 1987. The threads are split into groups of fan_in, and
+// every group counts its arrivals in a tree node of its own. The last thread
+// to arrive at a node goes on to its parent node, which counts the arrivals
+// of fan_in child nodes. The last thread to arrive at the root flips a global
+// sense-reversing flag that all threads wait on. The count of every node is
+// contended by only fan_in threads.
+
+template <bool Park>
+class user_barrier_combining_tree final : public user_barrier {
+private:
+    struct alignas(CACHE_LINE_SIZE) node {
+        std::atomic<int> count;
+        // Number of arrivals expected at this node
+        int fan_in;
+        // Index of the parent node, -1 for the root
+        int parent;
+    };
+
+    // The leaves come first, thread t arrives at node t / fan_in
+    std::unique_ptr<node[]> m_nodes;
+    barrier_flag<Park> m_sense;
+    std::unique_ptr<padded<int>[]> m_local_sense;
+
+    // Counts an arrival at node n, returns true if the caller was the last
+    // thread to arrive at the root
+    bool arrive(int n);
+
+public:
+    static constexpr const char *name =
+        Park ? "combining_tree_park" : "combining_tree";
+    static const int fan_in = 4;
+
+    explicit user_barrier_combining_tree(int threads);
+
+    void wait(int thread_id) override;
+};
+
+/*******************************************************************************
+ *                         Implementations and dispatch                        *
+ ******************************************************************************/
+
+#include "user_barrier_central.hpp"
+#include "user_barrier_combining_tree.hpp"
+#include "user_barrier_dissemination.hpp"
+#include "user_barrier_pthread.hpp"
+#include "user_barrier_tournament.hpp"
+
+template <typename... Barriers>
+struct user_barrier_list {};
+
+// All barriers, in the order in which they are listed in
+// user_barrier_registry
+using user_barrier_types =
+    user_barrier_list<user_barrier_pthread, user_barrier_central<false>,
+                      user_barrier_central<true>,
+                      user_barrier_dissemination<false>,
+                      user_barrier_dissemination<true>,
+                      user_barrier_tournament<false>,
+                      user_barrier_tournament<true>,
+                      user_barrier_combining_tree<false>,
+                      user_barrier_combining_tree<true>>;
+
+template <typename F, typename... Barriers>
+bool user_barrier_visit(user_barrier_list<Barriers...>, const char *name,
+                        int threads, F &f) {
+    auto visit_one = [&](auto *type_tag) {
+        using Barrier = std::remove_pointer_t<decltype(type_tag)>;
+        if (strcmp(name, Barrier::name) != 0) {
+            return false;
+        }
+        std::unique_ptr<Barrier> barrier(new Barrier(threads));
+        f(*barrier);
+        return true;
+    };
+    return (visit_one(static_cast<Barriers *>(nullptr)) || ...);
+}
+
+/**
+ * This function creates a barrier by name, like user_barrier_create(), and
+ * calls f with a reference of the barrier's concrete type, see
+ * user_lock_visit().
+ *
+ * Returns:
+ *	false if there is no barrier with that name.
+ */
+template <typename F>
+bool user_barrier_visit(const char *name, int threads, F &&f) {
+    return user_barrier_visit(user_barrier_types(), name, threads, f);
+}
+
+#endif // USER_BARRIERS_HPP
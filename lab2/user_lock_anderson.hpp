@@ -0,0 +1,49 @@
+#ifndef USER_LOCK_ANDERSON_HPP
+#define USER_LOCK_ANDERSON_HPP
+
+#include "user_locks.hpp"
+
+inline unsigned round_up_pow2(unsigned value) {
+    unsigned pow2 = 1;
+    while (pow2 < value) {
+        pow2 <<= 1;
+    }
+    return pow2;
+}
+
+template <typename Backoff>
+inline user_lock_anderson_t<Backoff>::user_lock_anderson_t(int max_threads)
+    : user_lock()
+    , m_no_slots(round_up_pow2(max_threads))
+    , m_my_slot(new padded<unsigned>[max_threads])
+    , m_next_slot(0) {
+    m_slots.reset(new slot[m_no_slots]);
+    for (unsigned i = 0; i < m_no_slots; ++i) {
+        m_slots[i].value = false;
+    }
+    // The first thread to arrive gets the lock immediately
+    m_slots[0].value = true;
+}
+
+template <typename Backoff>
+inline void user_lock_anderson_t<Backoff>::lock(int thread_id) {
+    const unsigned my_slot =
+        m_next_slot.fetch_add(1, std::memory_order_relaxed) & (m_no_slots - 1);
+
+    Backoff backoff(m_backoff);
+    while (!m_slots[my_slot].value.load(std::memory_order_acquire)) {
+        backoff.pause();
+    }
+
+    // Reset the slot for the thread that will get it next time around
+    m_slots[my_slot].value.store(false, std::memory_order_relaxed);
+    m_my_slot[thread_id].value = my_slot;
+}
+
+template <typename Backoff>
+inline void user_lock_anderson_t<Backoff>::unlock(int thread_id) {
+    const unsigned next = (m_my_slot[thread_id].value + 1) & (m_no_slots - 1);
+    m_slots[next].value.store(true, std::memory_order_release);
+}
+
+#endif // USER_LOCK_ANDERSON_HPP
@@ -0,0 +1,73 @@
+#ifndef USER_LOCK_BAKERY_HPP
+#define USER_LOCK_BAKERY_HPP
+
+#include "user_locks.hpp"
+
+// Memory order audit. lock() has two store->load dependencies, and each of
+// them needs a seq_cst fence:
+//  1. choosing = true must be visible before we read the other tickets.
+//     Otherwise another thread could see choosing == false and ticket == 0
+//     and enter, while we pick a ticket that ignores its ticket and enter too.
+//  2. Our ticket (and choosing = false) must be visible before we read the
+//     other threads' choosing flags and tickets. Otherwise two threads can
+//     both read the other's ticket as 0.
+// The choosing and ticket stores are release and the loads that wait for
+// them are acquire. A thread that reads choosing == false therefore sees the
+// ticket written before it, and a thread that reads the ticket written by the
+// lock holder in unlock() (or any later ticket) sees its critical section.
+
+template <typename Backoff>
+inline user_lock_bakery_t<Backoff>::user_lock_bakery_t(int max_threads)
+    : user_lock()
+    , m_customers(new customer[max_threads])
+    , m_no_threads(max_threads) {
+    for (int i = 0; i < max_threads; ++i) {
+        m_customers[i].choosing.store(false, std::memory_order_relaxed);
+        m_customers[i].ticket.store(0, std::memory_order_relaxed);
+    }
+}
+
+template <typename Backoff>
+inline void user_lock_bakery_t<Backoff>::lock(int thread_id) {
+    customer &me = m_customers[thread_id];
+
+    me.choosing.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    uint64_t max_ticket = 0;
+    for (int k = 0; k < m_no_threads; ++k) {
+        const uint64_t t =
+            m_customers[k].ticket.load(std::memory_order_relaxed);
+        max_ticket = t > max_ticket ? t : max_ticket;
+    }
+    const uint64_t my_ticket = max_ticket + 1;
+    me.ticket.store(my_ticket, std::memory_order_release);
+    me.choosing.store(false, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    for (int k = 0; k < m_no_threads; ++k) {
+        if (k == thread_id) {
+            continue;
+        }
+        customer &other = m_customers[k];
+        Backoff backoff(m_backoff);
+        while (other.choosing.load(std::memory_order_acquire)) {
+            backoff.pause();
+        }
+        // Wait while k has a ticket and is ahead of us
+        for (;;) {
+            const uint64_t t = other.ticket.load(std::memory_order_acquire);
+            if (t == 0 || t > my_ticket || (t == my_ticket && k > thread_id)) {
+                break;
+            }
+            backoff.pause();
+        }
+    }
+}
+
+template <typename Backoff>
+inline void user_lock_bakery_t<Backoff>::unlock(int thread_id) {
+    m_customers[thread_id].ticket.store(0, std::memory_order_release);
+}
+
+#endif // USER_LOCK_BAKERY_HPP
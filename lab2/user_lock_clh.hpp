@@ -1,6 +1,10 @@
+#ifndef USER_LOCK_CLH_HPP
+#define USER_LOCK_CLH_HPP
+
 #include "user_locks.hpp"
 
-user_lock_clh::user_lock_clh()
+template <typename Backoff>
+inline user_lock_clh_t<Backoff>::user_lock_clh_t()
     : user_lock()
     , m_tail(&m_cells[2]) {
     m_local[0].local_cell = &m_cells[0];
@@ -13,18 +17,21 @@ user_lock_clh::user_lock_clh()
     m_cells[2] = false;
 }
 
-void user_lock_clh::lock(int thread_id) {
+template <typename Backoff>
+inline void user_lock_clh_t<Backoff>::lock(int thread_id) {
     local_l *l = &m_local[thread_id];
+    Backoff backoff(m_backoff);
     
     l->local_cell->store(1);
     l->previous = m_tail.exchange(l->local_cell);
     while (l->previous->load() != 0)
     {
-        /* busy waiting */
+        backoff.pause();
     } 
 }
 
-void user_lock_clh::unlock(int thread_id) {
+template <typename Backoff>
+inline void user_lock_clh_t<Backoff>::unlock(int thread_id) {
     local_l *l = &m_local[thread_id];
     
     l->local_cell->store(0);
@@ -56,4 +63,6 @@ void user_lock_clh::unlock(int thread_id) {
 
 //     // Move the tail to the previous node, removing the current node from the queue
 //     l->local_cell = l->previous;
-// }
\ No newline at end of file
+// }
+
+#endif // USER_LOCK_CLH_HPP
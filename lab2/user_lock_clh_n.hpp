@@ -0,0 +1,46 @@
+#ifndef USER_LOCK_CLH_N_HPP
+#define USER_LOCK_CLH_N_HPP
+
+#include "user_locks.hpp"
+
+template <typename Backoff>
+inline user_lock_clh_n_t<Backoff>::user_lock_clh_n_t(int max_threads)
+    : user_lock()
+    , m_cells(new cell[max_threads + 1])
+    , m_local(new local_l[max_threads])
+    , m_tail(&m_cells[max_threads]) {
+    for (int i = 0; i <= max_threads; ++i) {
+        m_cells[i].value = false;
+    }
+
+    for (int i = 0; i < max_threads; ++i) {
+        m_local[i].local_cell = &m_cells[i];
+        m_local[i].previous = nullptr;
+    }
+}
+
+template <typename Backoff>
+inline void user_lock_clh_n_t<Backoff>::lock(int thread_id) {
+    local_l *l = &m_local[thread_id];
+
+    // Nobody can observe our cell before it is published by the exchange
+    l->local_cell->value.store(true, std::memory_order_relaxed);
+    l->previous = m_tail.exchange(l->local_cell, std::memory_order_acq_rel);
+    Backoff backoff(m_backoff);
+    while (l->previous->value.load(std::memory_order_acquire)) {
+        backoff.pause();
+    }
+}
+
+template <typename Backoff>
+inline void user_lock_clh_n_t<Backoff>::unlock(int thread_id) {
+    local_l *l = &m_local[thread_id];
+
+    l->local_cell->value.store(false, std::memory_order_release);
+
+    // Our successor may still be spinning on our cell, recycle the cell of
+    // our predecessor instead. Nobody will look at it again.
+    l->local_cell = l->previous;
+}
+
+#endif // USER_LOCK_CLH_N_HPP
@@ -0,0 +1,57 @@
+#ifndef USER_LOCK_COHORT_HPP
+#define USER_LOCK_COHORT_HPP
+
+#include "user_locks.hpp"
+
+#include <cstdlib>
+
+template <typename Backoff>
+inline user_lock_cohort_t<Backoff>::user_lock_cohort_t(int max_threads,
+                                                      unsigned pass_bound)
+    : user_lock()
+    , m_thread_node(new padded<int>[max_threads])
+    , m_pass_bound(pass_bound) {
+    if (!m_pass_bound) {
+        const char *env = getenv("COHORT_PASS_BOUND");
+        m_pass_bound = env ? (unsigned)atoi(env) : 64;
+    }
+
+    for (int i = 0; i < numa_node_count(); ++i) {
+        m_cohorts.emplace_back(new cohort(max_threads));
+    }
+}
+
+template <typename Backoff>
+inline void user_lock_cohort_t<Backoff>::lock(int thread_id) {
+    const int node = thread_numa_node(thread_id);
+    cohort &c = *m_cohorts[node];
+    m_thread_node[thread_id].value = node;
+
+    c.local.lock(thread_id);
+    // The local lock orders this with the write by the previous holder
+    if (!c.global_owned) {
+        m_global.lock(thread_id);
+        c.passes = 0;
+    }
+}
+
+template <typename Backoff>
+inline void user_lock_cohort_t<Backoff>::unlock(int thread_id) {
+    cohort &c = *m_cohorts[m_thread_node[thread_id].value];
+
+    // A thread that starts waiting after the check finds global_owned ==
+    // false and competes for the global lock, so missing it is harmless.
+    if (c.passes < m_pass_bound && c.local.has_waiters(thread_id)) {
+        c.passes++;
+        c.global_owned = true;
+    } else {
+        c.global_owned = false;
+        // The ticket lock can be released by another thread than the one
+        // that acquired it (it is thread-oblivious), which is what makes
+        // passing it on safe.
+        m_global.unlock(thread_id);
+    }
+    c.local.unlock(thread_id);
+}
+
+#endif // USER_LOCK_COHORT_HPP
@@ -0,0 +1,54 @@
+#ifndef USER_LOCK_DEKKER_HPP
+#define USER_LOCK_DEKKER_HPP
+
+#include "user_locks.hpp"
+
+// Memory order audit. Dekker's algorithm is correct if every thread's write
+// of its own flag is ordered before its read of the other thread's flag.
+// That is store->load ordering, which neither acquire nor release provide
+// (even TSO reorders a store with a later load), so a seq_cst fence is
+// needed between the two. Every other access only needs:
+//  - The flag loads are acquire and the flag store in unlock() is release.
+//    This makes the critical section of the previous holder happen before
+//    ours.
+//  - m_turn only decides who backs off and so only affects progress, not
+//    mutual exclusion. A relaxed store becomes visible eventually, which is
+//    all that the waiting loop needs.
+
+template <typename Backoff>
+inline user_lock_dekker_t<Backoff>::user_lock_dekker_t()
+    : user_lock() {
+    m_flag[0] = m_flag[1] = false;
+    m_turn = false;
+}
+
+template <typename Backoff>
+inline void user_lock_dekker_t<Backoff>::lock(int thread_id) {
+    const int other_thread = 1 - thread_id;
+    Backoff backoff(m_backoff);
+
+    m_flag[thread_id].store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    while (m_flag[other_thread].load(std::memory_order_acquire)) {
+        if (m_turn.load(std::memory_order_relaxed) != thread_id) {
+            m_flag[thread_id].store(false, std::memory_order_relaxed);
+            while (m_turn.load(std::memory_order_relaxed) != thread_id) {
+                backoff.pause();
+            }
+            m_flag[thread_id].store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        } else {
+            backoff.pause();
+        }
+    }
+}
+
+template <typename Backoff>
+inline void user_lock_dekker_t<Backoff>::unlock(int thread_id) {
+    const int other_thread = 1 - thread_id;
+
+    m_turn.store(other_thread, std::memory_order_relaxed);
+    m_flag[thread_id].store(false, std::memory_order_release);
+}
+
+#endif // USER_LOCK_DEKKER_HPP
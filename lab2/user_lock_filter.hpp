@@ -0,0 +1,62 @@
+#ifndef USER_LOCK_FILTER_HPP
+#define USER_LOCK_FILTER_HPP
+
+#include "user_locks.hpp"
+
+// Memory order audit. At every level a thread writes its level and the
+// victim and then reads the levels of the other threads and the victim. As in
+// Dekker's algorithm the writes must be ordered before the reads (store->load
+// ordering), which takes a seq_cst fence, one per level. Otherwise two
+// threads could both read stale levels and pass the same level.
+//
+// The loads are acquire and the level stores are release. A thread that sees
+// a level written by the previous lock holder after it released the lock
+// (0 or any later level) therefore also sees its critical section.
+
+template <typename Backoff>
+inline user_lock_filter_t<Backoff>::user_lock_filter_t(int max_threads)
+    : user_lock()
+    , m_level(new padded<std::atomic<int>>[max_threads])
+    , m_victim(new padded<std::atomic<int>>[max_threads])
+    , m_no_threads(max_threads) {
+    for (int i = 0; i < max_threads; ++i) {
+        m_level[i].value.store(0, std::memory_order_relaxed);
+        m_victim[i].value.store(-1, std::memory_order_relaxed);
+    }
+}
+
+template <typename Backoff>
+inline void user_lock_filter_t<Backoff>::lock(int thread_id) {
+    for (int level = 1; level < m_no_threads; ++level) {
+        m_level[thread_id].value.store(level, std::memory_order_release);
+        m_victim[level].value.store(thread_id, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        // Wait while we are the victim and another thread is at this level
+        // or above
+        Backoff backoff(m_backoff);
+        for (;;) {
+            if (m_victim[level].value.load(std::memory_order_acquire) !=
+                thread_id) {
+                break;
+            }
+            bool conflict = false;
+            for (int k = 0; k < m_no_threads && !conflict; ++k) {
+                conflict = k != thread_id &&
+                           m_level[k].value.load(std::memory_order_acquire) >=
+                               level;
+            }
+            if (!conflict) {
+                break;
+            }
+            backoff.pause();
+        }
+    }
+}
+
+template <typename Backoff>
+inline void user_lock_filter_t<Backoff>::unlock(int thread_id) {
+    m_level[thread_id].value.store(0, std::memory_order_release);
+}
+
+#endif // USER_LOCK_FILTER_HPP
@@ -0,0 +1,62 @@
+#ifndef USER_LOCK_FUTEX_HPP
+#define USER_LOCK_FUTEX_HPP
+
+#include "user_locks.hpp"
+
+#include <algorithm>
+
+inline user_lock_futex::user_lock_futex()
+    : user_lock()
+    , m_state(0)
+    , m_spin_avg(0) {
+}
+
+inline void user_lock_futex::lock(int) {
+    int c = 0;
+    if (m_state.compare_exchange_strong(c, 1, std::memory_order_acquire,
+                                        std::memory_order_relaxed)) {
+        return;
+    }
+
+    // Spin for a while before going to sleep, the lock holder is likely to
+    // release the lock soon if our critical sections are short. The spin
+    // limit adapts to how long it has recently taken to get the lock by
+    // spinning (the same heuristic as glibc's adaptive mutexes).
+    const int avg = m_spin_avg.load(std::memory_order_relaxed);
+    const int limit = std::min(max_spins, 2 * avg + 10);
+    for (int spins = 0; spins < limit; ++spins) {
+        cpu_relax();
+        c = m_state.load(std::memory_order_relaxed);
+        if (c == 0 &&
+            m_state.compare_exchange_strong(c, 1, std::memory_order_acquire,
+                                            std::memory_order_relaxed)) {
+            m_spin_avg.store(avg + (spins - avg) / 8,
+                             std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    // Spinning did not pay off (e.g. the lock holder has been preempted),
+    // spin for less next time
+    m_spin_avg.store(avg - avg / 8, std::memory_order_relaxed);
+
+    // Mark the lock as contended and sleep until it is released. Once we have
+    // been asleep we don't know if there are other sleepers, so we must
+    // always take the lock in state 2 to make sure unlock() wakes them.
+    if (c != 2) {
+        c = m_state.exchange(2, std::memory_order_acquire);
+    }
+    while (c != 0) {
+        futex_syscall(&m_state, FUTEX_WAIT, 2);
+        c = m_state.exchange(2, std::memory_order_acquire);
+    }
+}
+
+inline void user_lock_futex::unlock(int) {
+    // Only enter the kernel if somebody might be sleeping
+    if (m_state.exchange(0, std::memory_order_release) == 2) {
+        futex_syscall(&m_state, FUTEX_WAKE, 1);
+    }
+}
+
+#endif // USER_LOCK_FUTEX_HPP
@@ -0,0 +1,89 @@
+#ifndef USER_LOCK_K42_HPP
+#define USER_LOCK_K42_HPP
+
+#include "user_locks.hpp"
+
+// Implementation based on Scott, "Shared-Memory Synchronization", Sec. 4.3.2.
+// While the lock is held, m_q.tail points to the last waiting node, or to m_q
+// itself if there are no waiters. m_q.next points to the first waiter.
+
+template <typename Backoff>
+inline user_lock_k42_t<Backoff>::user_lock_k42_t()
+    : user_lock() {
+    m_q.tail = nullptr;
+    m_q.next = nullptr;
+}
+
+template <typename Backoff>
+inline void user_lock_k42_t<Backoff>::lock(int) {
+    for (;;) {
+        qnode *prev = m_q.tail.load(std::memory_order_relaxed);
+        if (!prev) {
+            // The lock appears to be free
+            if (m_q.tail.compare_exchange_strong(prev, &m_q,
+                                                 std::memory_order_acquire,
+                                                 std::memory_order_relaxed)) {
+                return;
+            }
+        } else {
+            qnode n;
+            n.tail.store(waiting(), std::memory_order_relaxed);
+            n.next.store(nullptr, std::memory_order_relaxed);
+            if (!m_q.tail.compare_exchange_strong(prev, &n,
+                                                  std::memory_order_acq_rel,
+                                                  std::memory_order_relaxed)) {
+                continue;
+            }
+
+            // We are in line, wait for the lock to be handed over
+            prev->next.store(&n, std::memory_order_release);
+            Backoff backoff(m_backoff);
+            while (n.tail.load(std::memory_order_acquire) == waiting()) {
+                backoff.pause();
+            }
+
+            // We have the lock. Our node lives on our stack, so move our
+            // successor (if any) into the lock's node before returning.
+            qnode *succ = n.next.load(std::memory_order_acquire);
+            if (!succ) {
+                m_q.next.store(nullptr, std::memory_order_relaxed);
+                qnode *expected = &n;
+                if (!m_q.tail.compare_exchange_strong(
+                        expected, &m_q, std::memory_order_acq_rel,
+                        std::memory_order_relaxed)) {
+                    // Somebody got into the timing window, wait for the link
+                    Backoff link_backoff(m_backoff);
+                    while (!(succ = n.next.load(std::memory_order_acquire))) {
+                        link_backoff.pause();
+                    }
+                    m_q.next.store(succ, std::memory_order_relaxed);
+                }
+            } else {
+                m_q.next.store(succ, std::memory_order_relaxed);
+            }
+            return;
+        }
+    }
+}
+
+template <typename Backoff>
+inline void user_lock_k42_t<Backoff>::unlock(int) {
+    qnode *succ = m_q.next.load(std::memory_order_acquire);
+    if (!succ) {
+        qnode *expected = &m_q;
+        if (m_q.tail.compare_exchange_strong(expected, nullptr,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed)) {
+            return;
+        }
+
+        Backoff backoff(m_backoff);
+        while (!(succ = m_q.next.load(std::memory_order_acquire))) {
+            backoff.pause();
+        }
+    }
+
+    succ->tail.store(nullptr, std::memory_order_release);
+}
+
+#endif // USER_LOCK_K42_HPP
@@ -0,0 +1,73 @@
+#ifndef USER_LOCK_MCS_HPP
+#define USER_LOCK_MCS_HPP
+
+#include "user_locks.hpp"
+
+template <typename Backoff>
+inline user_lock_mcs_t<Backoff>::user_lock_mcs_t(int max_threads)
+    : user_lock()
+    , m_nodes(new qnode[max_threads])
+    , m_tail(nullptr) {
+}
+
+template <typename Backoff>
+inline void user_lock_mcs_t<Backoff>::lock(qnode *node) {
+    node->next.store(nullptr, std::memory_order_relaxed);
+    node->locked.store(true, std::memory_order_relaxed);
+
+    qnode *prev = m_tail.exchange(node, std::memory_order_acq_rel);
+    if (prev) {
+        // Link us in behind our predecessor and spin on our own node until
+        // it hands the lock over
+        prev->next.store(node, std::memory_order_release);
+        Backoff backoff(m_backoff);
+        while (node->locked.load(std::memory_order_acquire)) {
+            backoff.pause();
+        }
+    }
+}
+
+template <typename Backoff>
+inline void user_lock_mcs_t<Backoff>::unlock(qnode *node) {
+    qnode *succ = node->next.load(std::memory_order_acquire);
+    if (!succ) {
+        // No known successor, try to mark the lock as free
+        qnode *expected = node;
+        if (m_tail.compare_exchange_strong(expected, nullptr,
+                                           std::memory_order_release,
+                                           std::memory_order_relaxed)) {
+            return;
+        }
+
+        // Somebody is in the middle of enqueuing, wait for the link
+        Backoff backoff(m_backoff);
+        while (!(succ = node->next.load(std::memory_order_acquire))) {
+            backoff.pause();
+        }
+    }
+
+    succ->locked.store(false, std::memory_order_release);
+}
+
+template <typename Backoff>
+inline bool user_lock_mcs_t<Backoff>::has_waiters(const qnode *node) const {
+    return node->next.load(std::memory_order_relaxed) != nullptr ||
+           m_tail.load(std::memory_order_relaxed) != node;
+}
+
+template <typename Backoff>
+inline bool user_lock_mcs_t<Backoff>::has_waiters(int thread_id) const {
+    return has_waiters(&m_nodes[thread_id]);
+}
+
+template <typename Backoff>
+inline void user_lock_mcs_t<Backoff>::lock(int thread_id) {
+    lock(&m_nodes[thread_id]);
+}
+
+template <typename Backoff>
+inline void user_lock_mcs_t<Backoff>::unlock(int thread_id) {
+    unlock(&m_nodes[thread_id]);
+}
+
+#endif // USER_LOCK_MCS_HPP
@@ -0,0 +1,14 @@
+#ifndef USER_LOCK_MUTEX_HPP
+#define USER_LOCK_MUTEX_HPP
+
+#include "user_locks.hpp"
+
+inline void user_lock_mutex::lock(int) {
+    m_lock.lock();
+}
+
+inline void user_lock_mutex::unlock(int) {
+    m_lock.unlock();
+}
+
+#endif // USER_LOCK_MUTEX_HPP
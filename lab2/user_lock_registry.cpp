@@ -0,0 +1,39 @@
+#include "user_locks.hpp"
+
+template <typename Lock>
+static user_lock *create_lock(int max_threads) {
+#ifdef LOCK_PROFILE
+    return new profiled_lock<Lock>(user_lock_new<Lock>(max_threads),
+                                   max_threads);
+#else
+    return user_lock_new<Lock>(max_threads);
+#endif
+}
+
+template <typename List>
+struct registry_of;
+
+template <typename... Locks>
+struct registry_of<user_lock_list<Locks...>> {
+    static constexpr user_lock_info entries[] = {
+        {Locks::name, Locks::thread_limit, create_lock<Locks>}...,
+        {nullptr, 0, nullptr},
+    };
+};
+
+const user_lock_info *const user_lock_registry =
+    registry_of<user_lock_types>::entries;
+
+user_lock *user_lock_create(const char *name, int max_threads) {
+    for (const user_lock_info *info = user_lock_registry; info->name; ++info) {
+        if (strcmp(info->name, name) != 0) {
+            continue;
+        }
+        if (info->max_threads && max_threads > info->max_threads) {
+            return nullptr;
+        }
+        return info->create(max_threads);
+    }
+
+    return nullptr;
+}
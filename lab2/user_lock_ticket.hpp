@@ -0,0 +1,40 @@
+#ifndef USER_LOCK_TICKET_HPP
+#define USER_LOCK_TICKET_HPP
+
+#include "user_locks.hpp"
+
+inline user_lock_ticket::user_lock_ticket(unsigned backoff_base)
+    : user_lock()
+    , m_next_ticket(0)
+    , m_now_serving(0)
+    , m_backoff_base(backoff_base) {
+}
+
+inline void user_lock_ticket::lock(int) {
+    const unsigned my_ticket =
+        m_next_ticket.fetch_add(1, std::memory_order_relaxed);
+
+    for (;;) {
+        const unsigned now_serving =
+            m_now_serving.load(std::memory_order_acquire);
+        if (now_serving == my_ticket) {
+            return;
+        }
+
+        // Proportional backoff: the further back in the queue we are, the
+        // longer it will take until it is our turn. Polling less often
+        // reduces the traffic on m_now_serving for the lock holder.
+        const unsigned ahead = my_ticket - now_serving;
+        for (unsigned i = 0; i < ahead * m_backoff_base; ++i) {
+            cpu_relax();
+        }
+    }
+}
+
+inline void user_lock_ticket::unlock(int) {
+    // Only the lock holder writes m_now_serving
+    const unsigned next = m_now_serving.load(std::memory_order_relaxed) + 1;
+    m_now_serving.store(next, std::memory_order_release);
+}
+
+#endif // USER_LOCK_TICKET_HPP
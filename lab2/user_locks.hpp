@@ -2,12 +2,36 @@
 #define USER_LOCKS_HPP
 
 #include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
 #include <mutex>
+#include <type_traits>
+#include <vector>
+
+#include "backoff.hpp"
+#include "sync_common.hpp"
 
 /*******************************************************************************
  *                               Base Lock Class                               *
  ******************************************************************************/
 
+// The locks below derive from user_lock so that they can be selected at
+// runtime (see user_lock_create()). They are all final and implemented in
+// headers, so code that knows the concrete lock type calls them without going
+// through the vtable and can inline them (see user_lock_visit()). Every lock
+// also provides its registry name and thread limit as static members.
+//
+// The spinning locks are templates on a backoff policy (see backoff.hpp) for
+// their wait loops. The plain names of dekker, clh, clh_n, mcs, k42 and cohort
+// are the instances without backoff, <name>_pause, <name>_exp and
+// <name>_adaptive the instances with the other policies. anderson, filter and
+// bakery always paused between two polls, their plain names are the instances
+// with backoff_pause, <name>_exp and <name>_adaptive the others. The ticket
+// lock backs off in proportion to its position in the queue, which is more
+// than a generic policy knows, and futex bounds its spin phase by the number
+// of polls, so they have no policy parameter.
+
 class user_lock {
 
 public:
@@ -17,15 +41,49 @@ public:
     virtual ~user_lock(){};
 };
 
+/*******************************************************************************
+ *                                Lock registry                                *
+ ******************************************************************************/
+
+struct user_lock_info {
+    // Name used to select the lock in the tests and benchmarks
+    const char *name;
+    // The maximum number of threads supported by the lock, 0 if unlimited
+    int max_threads;
+    // Creates a lock for use by threads with the ids 0 to max_threads - 1
+    user_lock *(*create)(int max_threads);
+};
+
+// All available locks, terminated by an entry with name == nullptr
+extern const user_lock_info *const user_lock_registry;
+
+/**
+ * This function creates a lock by name. E.g.:
+ *
+ * std::unique_ptr<user_lock> lock(user_lock_create("mcs", 4));
+ *
+ * Arguments:
+ *	name: The name of the lock in user_lock_registry.
+ *	max_threads: The number of threads that will use the lock.
+ *
+ * Returns:
+ *	The new lock, or nullptr if there is no lock with that name or the
+ *	lock does not support max_threads threads.
+ */
+user_lock *user_lock_create(const char *name, int max_threads);
+
 /*******************************************************************************
  *                            std::mutex based lock                            *
  ******************************************************************************/
 
-class user_lock_mutex : public user_lock {
+class user_lock_mutex final : public user_lock {
 private:
     std::mutex m_lock;
 
 public:
+    static constexpr const char *name = "mutex";
+    static constexpr int thread_limit = 0;
+
     void lock(int thread_id) override;
     void unlock(int thread_id) override;
 };
@@ -34,25 +92,57 @@ public:
  *                      Lock based on Dekker's algorithm                       *
  ******************************************************************************/
 
-class user_lock_dekker : public user_lock {
+template <typename Backoff>
+inline constexpr const char *dekker_name = nullptr;
+template <>
+inline constexpr const char *dekker_name<backoff_none> = "dekker";
+template <>
+inline constexpr const char *dekker_name<backoff_pause> = "dekker_pause";
+template <>
+inline constexpr const char *dekker_name<backoff_exp> = "dekker_exp";
+template <>
+inline constexpr const char *dekker_name<backoff_adaptive> = "dekker_adaptive";
+
+template <typename Backoff>
+class user_lock_dekker_t final : public user_lock {
 private:
-    // TODO: Change the types as necessary
     // NOTE: The lock supports only two threads
     std::atomic<bool> m_flag[2];
     std::atomic<bool> m_turn;
+    typename Backoff::state m_backoff;
 
 public:
-    user_lock_dekker();
+    static constexpr const char *name = dekker_name<Backoff>;
+    static constexpr int thread_limit = 2;
+
+    user_lock_dekker_t();
 
     void lock(int thread_id) override;
     void unlock(int thread_id) override;
 };
 
+using user_lock_dekker = user_lock_dekker_t<backoff_none>;
+using user_lock_dekker_pause = user_lock_dekker_t<backoff_pause>;
+using user_lock_dekker_exp = user_lock_dekker_t<backoff_exp>;
+using user_lock_dekker_adaptive = user_lock_dekker_t<backoff_adaptive>;
+
 /*******************************************************************************
  *                            CLH Queue based lock                             *
  ******************************************************************************/
 
-class user_lock_clh : public user_lock {
+template <typename Backoff>
+inline constexpr const char *clh_name = nullptr;
+template <>
+inline constexpr const char *clh_name<backoff_none> = "clh";
+template <>
+inline constexpr const char *clh_name<backoff_pause> = "clh_pause";
+template <>
+inline constexpr const char *clh_name<backoff_exp> = "clh_exp";
+template <>
+inline constexpr const char *clh_name<backoff_adaptive> = "clh_adaptive";
+
+template <typename Backoff>
+class user_lock_clh_t final : public user_lock {
 private:
     using cell = std::atomic<bool>;
 
@@ -78,11 +168,562 @@ private:
     // This pointer stores the tail of the lock
     std::atomic<cell *> m_tail;
 
+    typename Backoff::state m_backoff;
+
+public:
+    static constexpr const char *name = clh_name<Backoff>;
+    static constexpr int thread_limit = 2;
+
+    user_lock_clh_t();
+
+    void lock(int thread_id) override;
+    void unlock(int thread_id) override;
+};
+
+using user_lock_clh = user_lock_clh_t<backoff_none>;
+using user_lock_clh_pause = user_lock_clh_t<backoff_pause>;
+using user_lock_clh_exp = user_lock_clh_t<backoff_exp>;
+using user_lock_clh_adaptive = user_lock_clh_t<backoff_adaptive>;
+
+/*******************************************************************************
+ *                      CLH Queue based lock, N threads                        *
+ ******************************************************************************/
+
+template <typename Backoff>
+inline constexpr const char *clh_n_name = nullptr;
+template <>
+inline constexpr const char *clh_n_name<backoff_none> = "clh_n";
+template <>
+inline constexpr const char *clh_n_name<backoff_pause> = "clh_n_pause";
+template <>
+inline constexpr const char *clh_n_name<backoff_exp> = "clh_n_exp";
+template <>
+inline constexpr const char *clh_n_name<backoff_adaptive> = "clh_n_adaptive";
+
+template <typename Backoff>
+class user_lock_clh_n_t final : public user_lock {
+private:
+    // Every cell is padded to a cache line, waiting threads spin on the cell
+    // of their predecessor and would otherwise suffer from false sharing.
+    using cell = padded<std::atomic<bool>>;
+
+    // One cell for each thread and one extra cell to be used as the initial
+    // unlocked tail. Cells are recycled: when a thread releases the lock it
+    // takes over the cell of its predecessor for its next acquire.
+    std::unique_ptr<cell[]> m_cells;
+
+    // The handle owned by each thread, accessed using m_local[thread_id]. No
+    // other thread ever touches it, it is padded to keep it that way.
+    struct alignas(CACHE_LINE_SIZE) local_l {
+        // Pointer to the cell we will enqueue next
+        cell *local_cell;
+        // Pointer to the previous node in the queue
+        cell *previous;
+    };
+    std::unique_ptr<local_l[]> m_local;
+
+    // This pointer stores the tail of the lock
+    alignas(CACHE_LINE_SIZE) std::atomic<cell *> m_tail;
+
+    typename Backoff::state m_backoff;
+
+public:
+    static constexpr const char *name = clh_n_name<Backoff>;
+    static constexpr int thread_limit = MAX_THREADS;
+
+    // max_threads: threads may use the ids 0 to max_threads - 1
+    explicit user_lock_clh_n_t(int max_threads = MAX_THREADS);
+
+    void lock(int thread_id) override;
+    void unlock(int thread_id) override;
+};
+
+using user_lock_clh_n = user_lock_clh_n_t<backoff_none>;
+using user_lock_clh_n_pause = user_lock_clh_n_t<backoff_pause>;
+using user_lock_clh_n_exp = user_lock_clh_n_t<backoff_exp>;
+using user_lock_clh_n_adaptive = user_lock_clh_n_t<backoff_adaptive>;
+
+/*******************************************************************************
+ *                            MCS Queue based lock                             *
+ ******************************************************************************/
+
+template <typename Backoff>
+inline constexpr const char *mcs_name = nullptr;
+template <>
+inline constexpr const char *mcs_name<backoff_none> = "mcs";
+template <>
+inline constexpr const char *mcs_name<backoff_pause> = "mcs_pause";
+template <>
+inline constexpr const char *mcs_name<backoff_exp> = "mcs_exp";
+template <>
+inline constexpr const char *mcs_name<backoff_adaptive> = "mcs_adaptive";
+
+template <typename Backoff>
+class user_lock_mcs_t final : public user_lock {
+public:
+    // The queue node of an acquirer. It must stay alive, and may not be used
+    // for anything else, from lock() until the matching unlock() returns.
+    struct alignas(CACHE_LINE_SIZE) qnode {
+        std::atomic<qnode *> next;
+        std::atomic<bool> locked;
+    };
+
+private:
+    // Nodes used by lock(thread_id), m_nodes[thread_id] belongs to thread_id
+    std::unique_ptr<qnode[]> m_nodes;
+
+    // This pointer stores the tail of the queue, nullptr when unlocked
+    alignas(CACHE_LINE_SIZE) std::atomic<qnode *> m_tail;
+
+    typename Backoff::state m_backoff;
+
+public:
+    static constexpr const char *name = mcs_name<Backoff>;
+    static constexpr int thread_limit = MAX_THREADS;
+
+    // max_threads: threads may use the ids 0 to max_threads - 1
+    explicit user_lock_mcs_t(int max_threads = MAX_THREADS);
+
+    // Acquire/release the lock using an explicit queue node, e.g. one
+    // allocated on the stack of the caller.
+    void lock(qnode *node);
+    void unlock(qnode *node);
+
+    // Returns true if other threads are queued behind the lock holder that
+    // used node (or thread_id). May only be called by the lock holder.
+    bool has_waiters(const qnode *node) const;
+    bool has_waiters(int thread_id) const;
+
+    void lock(int thread_id) override;
+    void unlock(int thread_id) override;
+};
+
+using user_lock_mcs = user_lock_mcs_t<backoff_none>;
+using user_lock_mcs_pause = user_lock_mcs_t<backoff_pause>;
+using user_lock_mcs_exp = user_lock_mcs_t<backoff_exp>;
+using user_lock_mcs_adaptive = user_lock_mcs_t<backoff_adaptive>;
+
+/*******************************************************************************
+ *                   K42 variant of the MCS Queue based lock                   *
+ ******************************************************************************/
+
+template <typename Backoff>
+inline constexpr const char *k42_name = nullptr;
+template <>
+inline constexpr const char *k42_name<backoff_none> = "k42";
+template <>
+inline constexpr const char *k42_name<backoff_pause> = "k42_pause";
+template <>
+inline constexpr const char *k42_name<backoff_exp> = "k42_exp";
+template <>
+inline constexpr const char *k42_name<backoff_adaptive> = "k42_adaptive";
+
+template <typename Backoff>
+class user_lock_k42_t final : public user_lock {
+private:
+    // Waiting threads enqueue a node on their own stack. The lock itself
+    // contains a node that is used as the queue node of the lock holder, so
+    // no node has to be passed from lock() to unlock().
+    struct alignas(CACHE_LINE_SIZE) qnode {
+        // For the lock's own node: the tail of the queue. For a waiting
+        // thread's node: set to waiting() until the lock is handed over.
+        std::atomic<qnode *> tail;
+        std::atomic<qnode *> next;
+    };
+
+    static qnode *waiting() {
+        return reinterpret_cast<qnode *>(1);
+    }
+
+    qnode m_q;
+
+    typename Backoff::state m_backoff;
+
+public:
+    static constexpr const char *name = k42_name<Backoff>;
+    static constexpr int thread_limit = 0;
+
+    user_lock_k42_t();
+
+    // The thread_id is not used, any number of threads may use the lock
+    void lock(int thread_id) override;
+    void unlock(int thread_id) override;
+};
+
+using user_lock_k42 = user_lock_k42_t<backoff_none>;
+using user_lock_k42_pause = user_lock_k42_t<backoff_pause>;
+using user_lock_k42_exp = user_lock_k42_t<backoff_exp>;
+using user_lock_k42_adaptive = user_lock_k42_t<backoff_adaptive>;
+
+/*******************************************************************************
+ *                 Ticket lock with proportional backoff                       *
+ ******************************************************************************/
+
+class user_lock_ticket final : public user_lock {
+private:
+    // The two counters are written by different threads (arriving threads
+    // and the lock holder), keep them in separate cache lines.
+    alignas(CACHE_LINE_SIZE) std::atomic<unsigned> m_next_ticket;
+    alignas(CACHE_LINE_SIZE) std::atomic<unsigned> m_now_serving;
+
+    // Number of pause instructions to back off for every thread ahead of us
+    // in the queue before we poll m_now_serving again.
+    unsigned m_backoff_base;
+
 public:
-    user_lock_clh();
+    static constexpr const char *name = "ticket";
+    static constexpr int thread_limit = 0;
+
+    explicit user_lock_ticket(unsigned backoff_base = 32);
 
+    // The thread_id is not used, any number of threads may use the lock
     void lock(int thread_id) override;
     void unlock(int thread_id) override;
 };
 
+/*******************************************************************************
+ *                   Array based queue lock (Anderson's lock)                  *
+ ******************************************************************************/
+
+template <typename Backoff>
+inline constexpr const char *anderson_name = nullptr;
+template <>
+inline constexpr const char *anderson_name<backoff_pause> = "anderson";
+template <>
+inline constexpr const char *anderson_name<backoff_exp> = "anderson_exp";
+template <>
+inline constexpr const char
+    *anderson_name<backoff_adaptive> = "anderson_adaptive";
+
+template <typename Backoff>
+class user_lock_anderson_t final : public user_lock {
+private:
+    // One flag per slot, each in a cache line of its own. The thread holding
+    // slot i spins on m_slots[i] until its predecessor sets it.
+    using slot = padded<std::atomic<bool>>;
+    std::unique_ptr<slot[]> m_slots;
+
+    // The number of slots, a power of two >= the number of threads so that
+    // slot numbers remain consistent when the ticket counter wraps around.
+    unsigned m_no_slots;
+
+    // The slot held by each thread, accessed using m_my_slot[thread_id]
+    std::unique_ptr<padded<unsigned>[]> m_my_slot;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<unsigned> m_next_slot;
+
+    typename Backoff::state m_backoff;
+
+public:
+    static constexpr const char *name = anderson_name<Backoff>;
+    static constexpr int thread_limit = MAX_THREADS;
+
+    // max_threads: threads may use the ids 0 to max_threads - 1
+    explicit user_lock_anderson_t(int max_threads = MAX_THREADS);
+
+    void lock(int thread_id) override;
+    void unlock(int thread_id) override;
+};
+
+using user_lock_anderson = user_lock_anderson_t<backoff_pause>;
+using user_lock_anderson_exp = user_lock_anderson_t<backoff_exp>;
+using user_lock_anderson_adaptive = user_lock_anderson_t<backoff_adaptive>;
+
+/*******************************************************************************
+ *                 Adaptive spin-then-park lock (Linux futex)                  *
+ ******************************************************************************/
+
+class user_lock_futex final : public user_lock {
+private:
+    // The lock word, also used as the futex:
+    //   0: unlocked
+    //   1: locked, no waiters
+    //   2: locked, there may be threads sleeping in the kernel
+    // See Drepper, "Futexes Are Tricky", mutex take 3.
+    alignas(CACHE_LINE_SIZE) std::atomic<int> m_state;
+
+    // Running average of the number of spins it took to get the lock when
+    // spinning succeeded. Updated racily by the lock holder, it is only a
+    // hint for how long it is worth spinning before going to sleep.
+    alignas(CACHE_LINE_SIZE) std::atomic<int> m_spin_avg;
+
+public:
+    static constexpr const char *name = "futex";
+    static constexpr int thread_limit = 0;
+
+    // Upper bound on the number of spins before parking in the kernel
+    static const int max_spins = 1000;
+
+    user_lock_futex();
+
+    // The thread_id is not used, any number of threads may use the lock
+    void lock(int thread_id) override;
+    void unlock(int thread_id) override;
+};
+
+/*******************************************************************************
+ *                      Filter lock (Peterson, N threads)                      *
+ ******************************************************************************/
+
+// Peterson's lock generalized to N threads (Herlihy & Shavit, Section 2.5).
+// A thread has to pass N - 1 levels to get the lock, and at every level one
+// thread (the last to arrive, the victim) is held back. Uses only loads and
+// stores, no read-modify-write instructions.
+
+template <typename Backoff>
+inline constexpr const char *filter_name = nullptr;
+template <>
+inline constexpr const char *filter_name<backoff_pause> = "filter";
+template <>
+inline constexpr const char *filter_name<backoff_exp> = "filter_exp";
+template <>
+inline constexpr const char *filter_name<backoff_adaptive> = "filter_adaptive";
+
+template <typename Backoff>
+class user_lock_filter_t final : public user_lock {
+private:
+    // The level every thread is trying to pass, 0 if it is not interested in
+    // the lock. Only written by its thread, accessed using m_level[thread_id].
+    std::unique_ptr<padded<std::atomic<int>>[]> m_level;
+    // The last thread to arrive at every level
+    std::unique_ptr<padded<std::atomic<int>>[]> m_victim;
+
+    int m_no_threads;
+
+    typename Backoff::state m_backoff;
+
+public:
+    static constexpr const char *name = filter_name<Backoff>;
+    static constexpr int thread_limit = MAX_THREADS;
+
+    // max_threads: threads may use the ids 0 to max_threads - 1
+    explicit user_lock_filter_t(int max_threads = MAX_THREADS);
+
+    void lock(int thread_id) override;
+    void unlock(int thread_id) override;
+};
+
+using user_lock_filter = user_lock_filter_t<backoff_pause>;
+using user_lock_filter_exp = user_lock_filter_t<backoff_exp>;
+using user_lock_filter_adaptive = user_lock_filter_t<backoff_adaptive>;
+
+/*******************************************************************************
+ *                            Lamport's bakery lock                            *
+ ******************************************************************************/
+
+// Threads take a ticket that is larger than all tickets they can see and are
+// served in ticket order, ties are broken by thread id. Uses only loads and
+// stores, no read-modify-write instructions. Unlike the filter lock it is
+// first-come-first-served.
+
+template <typename Backoff>
+inline constexpr const char *bakery_name = nullptr;
+template <>
+inline constexpr const char *bakery_name<backoff_pause> = "bakery";
+template <>
+inline constexpr const char *bakery_name<backoff_exp> = "bakery_exp";
+template <>
+inline constexpr const char *bakery_name<backoff_adaptive> = "bakery_adaptive";
+
+template <typename Backoff>
+class user_lock_bakery_t final : public user_lock {
+private:
+    struct alignas(CACHE_LINE_SIZE) customer {
+        // True while the thread picks its ticket
+        std::atomic<bool> choosing;
+        // The thread's ticket, 0 if it is not interested in the lock. The
+        // tickets grow as long as the lock is contended, 64 bits will not
+        // wrap around.
+        std::atomic<uint64_t> ticket;
+    };
+
+    // Only written by their own thread, accessed using m_customers[thread_id]
+    std::unique_ptr<customer[]> m_customers;
+
+    int m_no_threads;
+
+    typename Backoff::state m_backoff;
+
+public:
+    static constexpr const char *name = bakery_name<Backoff>;
+    static constexpr int thread_limit = MAX_THREADS;
+
+    // max_threads: threads may use the ids 0 to max_threads - 1
+    explicit user_lock_bakery_t(int max_threads = MAX_THREADS);
+
+    void lock(int thread_id) override;
+    void unlock(int thread_id) override;
+};
+
+using user_lock_bakery = user_lock_bakery_t<backoff_pause>;
+using user_lock_bakery_exp = user_lock_bakery_t<backoff_exp>;
+using user_lock_bakery_adaptive = user_lock_bakery_t<backoff_adaptive>;
+
+/*******************************************************************************
+ *                   NUMA-aware cohort lock (C-TKT-MCS)                        *
+ ******************************************************************************/
+
+// Lock cohorting, Dice, Marathe and Shavit, "Lock Cohorting: A General
+// Technique for Designing NUMA Locks". Every NUMA node has a local MCS lock,
+// and the holder of a local lock competes for a global ticket lock. When the
+// holder releases the lock while other threads of its node are waiting, it
+// passes the global lock on together with the local one. This keeps the lock,
+// and the data it protects, on one node for up to pass_bound acquisitions
+// before the global lock is released to give the other nodes a turn.
+// Backoff is the policy of the local MCS locks, the global ticket lock has a
+// backoff of its own.
+
+template <typename Backoff>
+inline constexpr const char *cohort_name = nullptr;
+template <>
+inline constexpr const char *cohort_name<backoff_none> = "cohort";
+template <>
+inline constexpr const char *cohort_name<backoff_pause> = "cohort_pause";
+template <>
+inline constexpr const char *cohort_name<backoff_exp> = "cohort_exp";
+template <>
+inline constexpr const char *cohort_name<backoff_adaptive> = "cohort_adaptive";
+
+template <typename Backoff>
+class user_lock_cohort_t final : public user_lock {
+private:
+    struct alignas(CACHE_LINE_SIZE) cohort {
+        user_lock_mcs_t<Backoff> local;
+        // True if the global lock was passed on with the local lock. Only
+        // accessed by the holder of the local lock.
+        bool global_owned = false;
+        // Number of consecutive local handoffs
+        unsigned passes = 0;
+
+        explicit cohort(int max_threads)
+            : local(max_threads) {
+        }
+    };
+
+    user_lock_ticket m_global;
+    std::vector<std::unique_ptr<cohort>> m_cohorts;
+
+    // The cohort each thread joined in lock(), accessed using
+    // m_thread_node[thread_id]. Threads may migrate, unlock() must use the
+    // same cohort as lock().
+    std::unique_ptr<padded<int>[]> m_thread_node;
+
+    unsigned m_pass_bound;
+
+public:
+    static constexpr const char *name = cohort_name<Backoff>;
+    static constexpr int thread_limit = MAX_THREADS;
+
+    // max_threads: threads may use the ids 0 to max_threads - 1
+    // pass_bound: maximum number of consecutive handoffs within a node, 0
+    // to use $COHORT_PASS_BOUND or 64 if that is not set.
+    //
+    // There is one cohort per NUMA node, see thread_numa_node(). Set
+    // $EMULATE_NUMA_NODES to exercise the global lock on a single node.
+    explicit user_lock_cohort_t(int max_threads = MAX_THREADS,
+                                unsigned pass_bound = 0);
+
+    void lock(int thread_id) override;
+    void unlock(int thread_id) override;
+};
+
+using user_lock_cohort = user_lock_cohort_t<backoff_none>;
+using user_lock_cohort_pause = user_lock_cohort_t<backoff_pause>;
+using user_lock_cohort_exp = user_lock_cohort_t<backoff_exp>;
+using user_lock_cohort_adaptive = user_lock_cohort_t<backoff_adaptive>;
+
+/*******************************************************************************
+ *                         Implementations and dispatch                        *
+ ******************************************************************************/
+
+#include "user_lock_anderson.hpp"
+#include "user_lock_bakery.hpp"
+#include "user_lock_clh.hpp"
+#include "user_lock_clh_n.hpp"
+#include "user_lock_cohort.hpp"
+#include "user_lock_dekker.hpp"
+#include "user_lock_filter.hpp"
+#include "user_lock_futex.hpp"
+#include "user_lock_k42.hpp"
+#include "user_lock_mcs.hpp"
+#include "user_lock_mutex.hpp"
+#include "user_lock_ticket.hpp"
+
+#ifdef LOCK_PROFILE
+#include "lock_profile.hpp"
+#endif
+
+template <typename... Locks>
+struct user_lock_list {};
+
+// All locks, in the order in which they are listed in user_lock_registry
+using user_lock_types =
+    user_lock_list<user_lock_mutex, user_lock_dekker, user_lock_clh,
+                   user_lock_clh_n, user_lock_mcs, user_lock_k42,
+                   user_lock_ticket, user_lock_anderson, user_lock_futex,
+                   user_lock_cohort, user_lock_filter, user_lock_bakery,
+                   user_lock_dekker_pause, user_lock_dekker_exp,
+                   user_lock_dekker_adaptive, user_lock_clh_pause,
+                   user_lock_clh_exp, user_lock_clh_adaptive,
+                   user_lock_mcs_pause, user_lock_mcs_exp,
+                   user_lock_mcs_adaptive, user_lock_clh_n_pause,
+                   user_lock_clh_n_exp, user_lock_clh_n_adaptive,
+                   user_lock_k42_pause, user_lock_k42_exp,
+                   user_lock_k42_adaptive, user_lock_anderson_exp,
+                   user_lock_anderson_adaptive, user_lock_cohort_pause,
+                   user_lock_cohort_exp, user_lock_cohort_adaptive,
+                   user_lock_filter_exp, user_lock_filter_adaptive,
+                   user_lock_bakery_exp, user_lock_bakery_adaptive>;
+
+// Creates a lock of the given type for max_threads threads. Locks with
+// per-thread state take the number of threads as their constructor argument.
+template <typename Lock>
+Lock *user_lock_new(int max_threads) {
+    if constexpr (Lock::thread_limit != 0 &&
+                  std::is_constructible<Lock, int>::value) {
+        return new Lock(max_threads);
+    } else {
+        (void)max_threads;
+        return new Lock();
+    }
+}
+
+template <typename F, typename... Locks>
+bool user_lock_visit(user_lock_list<Locks...>, const char *name,
+                     int max_threads, F &f) {
+    auto visit_one = [&](auto *type_tag) {
+        using Lock = std::remove_pointer_t<decltype(type_tag)>;
+        if (strcmp(name, Lock::name) != 0 ||
+            (Lock::thread_limit && max_threads > Lock::thread_limit)) {
+            return false;
+        }
+#ifdef LOCK_PROFILE
+        profiled_lock<Lock> lock(user_lock_new<Lock>(max_threads),
+                                 max_threads);
+        f(lock);
+#else
+        std::unique_ptr<Lock> lock(user_lock_new<Lock>(max_threads));
+        f(*lock);
+#endif
+        return true;
+    };
+    return (visit_one(static_cast<Locks *>(nullptr)) || ...);
+}
+
+/**
+ * This function creates a lock by name, like user_lock_create(), and calls
+ * f with a reference of the lock's concrete type. f is typically a generic
+ * lambda, which is then instantiated for every lock type. E.g.:
+ *
+ * user_lock_visit("mcs", 4, [](auto &lock) { run_threads(lock, ...); });
+ *
+ * Returns:
+ *	false if there is no lock with that name or the lock does not support
+ *	max_threads threads.
+ */
+template <typename F>
+bool user_lock_visit(const char *name, int max_threads, F &&f) {
+    return user_lock_visit(user_lock_types(), name, max_threads, f);
+}
+
 #endif // USER_LOCKS_HPP
@@ -0,0 +1,59 @@
+#ifndef USER_RWLOCK_BIGREADER_HPP
+#define USER_RWLOCK_BIGREADER_HPP
+
+#include "user_rwlocks.hpp"
+
+inline user_rwlock_bigreader::user_rwlock_bigreader(int max_threads)
+    : user_rwlock()
+    , m_reading(new padded<std::atomic<bool>>[max_threads])
+    , m_max_threads(max_threads)
+    , m_writer(false) {
+    for (int i = 0; i < max_threads; ++i) {
+        m_reading[i].value = false;
+    }
+}
+
+// A reader announces itself and then checks for a writer, a writer announces
+// itself and then checks for readers. The store must not be reordered with the
+// following load (like in Dekker's algorithm), hence the seq_cst accesses.
+
+inline void user_rwlock_bigreader::lock_shared(int thread_id) {
+    std::atomic<bool> &reading = m_reading[thread_id].value;
+
+    for (;;) {
+        reading.store(true, std::memory_order_seq_cst);
+        if (!m_writer.load(std::memory_order_seq_cst)) {
+            return;
+        }
+
+        // Back off until the writer is done
+        reading.store(false, std::memory_order_relaxed);
+        while (m_writer.load(std::memory_order_relaxed)) {
+            cpu_relax();
+        }
+    }
+}
+
+inline void user_rwlock_bigreader::unlock_shared(int thread_id) {
+    m_reading[thread_id].value.store(false, std::memory_order_release);
+}
+
+inline void user_rwlock_bigreader::lock(int) {
+    while (m_writer.exchange(true, std::memory_order_seq_cst)) {
+        while (m_writer.load(std::memory_order_relaxed)) {
+            cpu_relax();
+        }
+    }
+
+    for (int i = 0; i < m_max_threads; ++i) {
+        while (m_reading[i].value.load(std::memory_order_seq_cst)) {
+            cpu_relax();
+        }
+    }
+}
+
+inline void user_rwlock_bigreader::unlock(int) {
+    m_writer.store(false, std::memory_order_release);
+}
+
+#endif // USER_RWLOCK_BIGREADER_HPP
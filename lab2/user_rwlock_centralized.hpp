@@ -0,0 +1,57 @@
+#ifndef USER_RWLOCK_CENTRALIZED_HPP
+#define USER_RWLOCK_CENTRALIZED_HPP
+
+#include "user_rwlocks.hpp"
+
+inline user_rwlock_centralized::user_rwlock_centralized()
+    : user_rwlock()
+    , m_state(0) {
+}
+
+inline void user_rwlock_centralized::lock_shared(int) {
+    for (;;) {
+        // Don't bother the writer while it is there
+        while (m_state.load(std::memory_order_relaxed) & writer) {
+            cpu_relax();
+        }
+
+        if (!(m_state.fetch_add(reader_inc, std::memory_order_acquire) &
+              writer)) {
+            return;
+        }
+
+        // A writer got there first, it has priority
+        m_state.fetch_sub(reader_inc, std::memory_order_relaxed);
+    }
+}
+
+inline void user_rwlock_centralized::unlock_shared(int) {
+    m_state.fetch_sub(reader_inc, std::memory_order_release);
+}
+
+inline void user_rwlock_centralized::lock(int) {
+    // Claim the writer bit, this stops new readers from entering...
+    unsigned state = m_state.load(std::memory_order_relaxed);
+    for (;;) {
+        if (state & writer) {
+            cpu_relax();
+            state = m_state.load(std::memory_order_relaxed);
+        } else if (m_state.compare_exchange_weak(state, state | writer,
+                                                 std::memory_order_relaxed)) {
+            break;
+        }
+    }
+
+    // ...and wait for the readers that are already inside to leave
+    while (m_state.load(std::memory_order_acquire) != writer) {
+        cpu_relax();
+    }
+}
+
+inline void user_rwlock_centralized::unlock(int) {
+    // Readers may be adding and removing themselves while backing off, so we
+    // can't simply store 0.
+    m_state.fetch_sub(writer, std::memory_order_release);
+}
+
+#endif // USER_RWLOCK_CENTRALIZED_HPP
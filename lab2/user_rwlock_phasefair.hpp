@@ -0,0 +1,57 @@
+#ifndef USER_RWLOCK_PHASEFAIR_HPP
+#define USER_RWLOCK_PHASEFAIR_HPP
+
+#include "user_rwlocks.hpp"
+
+// Implementation based on Brandenburg and Anderson, "Spin-Based Reader-Writer
+// Synchronization for Multiprocessor Real-Time Systems", Listing 3 (PF-T).
+
+inline user_rwlock_phasefair::user_rwlock_phasefair()
+    : user_rwlock()
+    , m_rin(0)
+    , m_rout(0)
+    , m_win(0)
+    , m_wout(0) {
+}
+
+inline void user_rwlock_phasefair::lock_shared(int) {
+    const unsigned w =
+        m_rin.fetch_add(reader_inc, std::memory_order_acquire) & writer_bits;
+    if (w == 0) {
+        return;
+    }
+
+    // A writer is present, wait until it is done. The next writer will use
+    // the other phase id, so we don't wait for it.
+    while ((m_rin.load(std::memory_order_acquire) & writer_bits) == w) {
+        cpu_relax();
+    }
+}
+
+inline void user_rwlock_phasefair::unlock_shared(int) {
+    m_rout.fetch_add(reader_inc, std::memory_order_release);
+}
+
+inline void user_rwlock_phasefair::lock(int) {
+    const unsigned ticket = m_win.fetch_add(1, std::memory_order_relaxed);
+    while (m_wout.load(std::memory_order_acquire) != ticket) {
+        cpu_relax();
+    }
+
+    // Block new readers and wait for the readers that entered before us
+    const unsigned w = writer_present | (ticket & phase_id);
+    const unsigned readers = m_rin.fetch_add(w, std::memory_order_relaxed);
+    while (m_rout.load(std::memory_order_acquire) != readers) {
+        cpu_relax();
+    }
+}
+
+inline void user_rwlock_phasefair::unlock(int) {
+    // Let the readers in
+    m_rin.fetch_and(~writer_bits, std::memory_order_release);
+    // Only the lock holder writes m_wout
+    const unsigned next = m_wout.load(std::memory_order_relaxed) + 1;
+    m_wout.store(next, std::memory_order_release);
+}
+
+#endif // USER_RWLOCK_PHASEFAIR_HPP
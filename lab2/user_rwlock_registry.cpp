@@ -0,0 +1,35 @@
+#include "user_rwlocks.hpp"
+
+template <typename Lock>
+static user_rwlock *create_lock(int max_threads) {
+    return user_rwlock_new<Lock>(max_threads);
+}
+
+template <typename List>
+struct registry_of;
+
+template <typename... Locks>
+struct registry_of<user_rwlock_list<Locks...>> {
+    static constexpr user_rwlock_info entries[] = {
+        {Locks::name, Locks::thread_limit, create_lock<Locks>}...,
+        {nullptr, 0, nullptr},
+    };
+};
+
+const user_rwlock_info *const user_rwlock_registry =
+    registry_of<user_rwlock_types>::entries;
+
+user_rwlock *user_rwlock_create(const char *name, int max_threads) {
+    for (const user_rwlock_info *info = user_rwlock_registry; info->name;
+         ++info) {
+        if (strcmp(info->name, name) != 0) {
+            continue;
+        }
+        if (info->max_threads && max_threads > info->max_threads) {
+            return nullptr;
+        }
+        return info->create(max_threads);
+    }
+
+    return nullptr;
+}
@@ -0,0 +1,22 @@
+#ifndef USER_RWLOCK_SHARED_MUTEX_HPP
+#define USER_RWLOCK_SHARED_MUTEX_HPP
+
+#include "user_rwlocks.hpp"
+
+inline void user_rwlock_shared_mutex::lock_shared(int) {
+    m_lock.lock_shared();
+}
+
+inline void user_rwlock_shared_mutex::unlock_shared(int) {
+    m_lock.unlock_shared();
+}
+
+inline void user_rwlock_shared_mutex::lock(int) {
+    m_lock.lock();
+}
+
+inline void user_rwlock_shared_mutex::unlock(int) {
+    m_lock.unlock();
+}
+
+#endif // USER_RWLOCK_SHARED_MUTEX_HPP
@@ -0,0 +1,229 @@
+#ifndef USER_RWLOCKS_HPP
+#define USER_RWLOCKS_HPP
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <shared_mutex>
+#include <type_traits>
+
+#include "sync_common.hpp"
+
+/*******************************************************************************
+ *                          Base Reader-Writer Lock Class                      *
+ ******************************************************************************/
+
+// Like the exclusive locks (see user_locks.hpp), the reader-writer locks are
+// final, implemented in headers and can be used without virtual calls through
+// user_rwlock_visit().
+
+class user_rwlock {
+
+public:
+    // Shared (read) access, any number of readers may hold the lock at once
+    virtual void lock_shared(int thread_id) = 0;
+    virtual void unlock_shared(int thread_id) = 0;
+
+    // Exclusive (write) access
+    virtual void lock(int thread_id) = 0;
+    virtual void unlock(int thread_id) = 0;
+
+    virtual ~user_rwlock(){};
+};
+
+/*******************************************************************************
+ *                         Reader-writer lock registry                         *
+ ******************************************************************************/
+
+struct user_rwlock_info {
+    // Name used to select the lock in the tests and benchmarks
+    const char *name;
+    // The maximum number of threads supported by the lock, 0 if unlimited
+    int max_threads;
+    // Creates a lock for use by threads with the ids 0 to max_threads - 1
+    user_rwlock *(*create)(int max_threads);
+};
+
+// All available locks, terminated by an entry with name == nullptr
+extern const user_rwlock_info *const user_rwlock_registry;
+
+/**
+ * This function creates a reader-writer lock by name, see user_lock_create().
+ *
+ * Returns:
+ *	The new lock, or nullptr if there is no lock with that name or the
+ *	lock does not support max_threads threads.
+ */
+user_rwlock *user_rwlock_create(const char *name, int max_threads);
+
+/*******************************************************************************
+ *                        std::shared_mutex based lock                         *
+ ******************************************************************************/
+
+class user_rwlock_shared_mutex final : public user_rwlock {
+private:
+    std::shared_mutex m_lock;
+
+public:
+    static constexpr const char *name = "shared_mutex";
+    static constexpr int thread_limit = 0;
+
+    void lock_shared(int thread_id) override;
+    void unlock_shared(int thread_id) override;
+    void lock(int thread_id) override;
+    void unlock(int thread_id) override;
+};
+
+/*******************************************************************************
+ *                     Centralized counter reader-writer lock                  *
+ ******************************************************************************/
+
+class user_rwlock_centralized final : public user_rwlock {
+private:
+    // Bit 0 is set while a writer holds, or is waiting for, the lock. The
+    // remaining bits count the readers, in units of reader_inc. Every
+    // acquire and release writes this word, so it bounces between the cores
+    // of the readers even though they never wait for each other.
+    static const unsigned writer = 1;
+    static const unsigned reader_inc = 2;
+    alignas(CACHE_LINE_SIZE) std::atomic<unsigned> m_state;
+
+public:
+    static constexpr const char *name = "centralized";
+    static constexpr int thread_limit = 0;
+
+    user_rwlock_centralized();
+
+    // The thread_id is not used, any number of threads may use the lock
+    void lock_shared(int thread_id) override;
+    void unlock_shared(int thread_id) override;
+    void lock(int thread_id) override;
+    void unlock(int thread_id) override;
+};
+
+/*******************************************************************************
+ *           Distributed reader-indicator lock (big-reader lock)               *
+ ******************************************************************************/
+
+class user_rwlock_bigreader final : public user_rwlock {
+private:
+    // One reader indicator per thread in a cache line of its own, so readers
+    // only write to their own line. Writers pay for this by having to check
+    // the indicators of all threads. The lab identifies threads, not cores,
+    // so the indicators are per thread rather than per core.
+    std::unique_ptr<padded<std::atomic<bool>>[]> m_reading;
+    int m_max_threads;
+
+    // Set while a writer holds, or is waiting for, the lock
+    alignas(CACHE_LINE_SIZE) std::atomic<bool> m_writer;
+
+public:
+    static constexpr const char *name = "bigreader";
+    static constexpr int thread_limit = MAX_THREADS;
+
+    // max_threads: threads may use the ids 0 to max_threads - 1
+    explicit user_rwlock_bigreader(int max_threads = MAX_THREADS);
+
+    void lock_shared(int thread_id) override;
+    void unlock_shared(int thread_id) override;
+    void lock(int thread_id) override;
+    void unlock(int thread_id) override;
+};
+
+/*******************************************************************************
+ *                       Phase-fair ticket reader-writer lock                  *
+ ******************************************************************************/
+
+class user_rwlock_phasefair final : public user_rwlock {
+private:
+    // Brandenburg and Anderson's PF-T lock. Reader and writer phases
+    // alternate: readers that arrive while a writer is waiting wait for at
+    // most one writer, and a writer waits for at most one reader phase.
+    //
+    // m_rin/m_rout count entering/exiting readers in units of reader_inc.
+    // The low bits of m_rin tell readers if a writer is present and which
+    // writer phase it is, so readers can tell when that writer has left.
+    static const unsigned reader_inc = 0x100;
+    static const unsigned writer_bits = 0x3;
+    static const unsigned writer_present = 0x2;
+    static const unsigned phase_id = 0x1;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<unsigned> m_rin;
+    alignas(CACHE_LINE_SIZE) std::atomic<unsigned> m_rout;
+    // Writers are ordered among themselves by a ticket lock
+    alignas(CACHE_LINE_SIZE) std::atomic<unsigned> m_win;
+    alignas(CACHE_LINE_SIZE) std::atomic<unsigned> m_wout;
+
+public:
+    static constexpr const char *name = "phasefair";
+    static constexpr int thread_limit = 0;
+
+    user_rwlock_phasefair();
+
+    // The thread_id is not used, any number of threads may use the lock
+    void lock_shared(int thread_id) override;
+    void unlock_shared(int thread_id) override;
+    void lock(int thread_id) override;
+    void unlock(int thread_id) override;
+};
+
+/*******************************************************************************
+ *                         Implementations and dispatch                        *
+ ******************************************************************************/
+
+#include "user_rwlock_bigreader.hpp"
+#include "user_rwlock_centralized.hpp"
+#include "user_rwlock_phasefair.hpp"
+#include "user_rwlock_shared_mutex.hpp"
+
+template <typename... Locks>
+struct user_rwlock_list {};
+
+// All locks, in the order in which they are listed in user_rwlock_registry
+using user_rwlock_types =
+    user_rwlock_list<user_rwlock_shared_mutex, user_rwlock_centralized,
+                     user_rwlock_bigreader, user_rwlock_phasefair>;
+
+// Creates a lock of the given type for max_threads threads, see
+// user_lock_new()
+template <typename Lock>
+Lock *user_rwlock_new(int max_threads) {
+    if constexpr (Lock::thread_limit != 0 &&
+                  std::is_constructible<Lock, int>::value) {
+        return new Lock(max_threads);
+    } else {
+        (void)max_threads;
+        return new Lock();
+    }
+}
+
+template <typename F, typename... Locks>
+bool user_rwlock_visit(user_rwlock_list<Locks...>, const char *name,
+                       int max_threads, F &f) {
+    auto visit_one = [&](auto *type_tag) {
+        using Lock = std::remove_pointer_t<decltype(type_tag)>;
+        if (strcmp(name, Lock::name) != 0 ||
+            (Lock::thread_limit && max_threads > Lock::thread_limit)) {
+            return false;
+        }
+        std::unique_ptr<Lock> lock(user_rwlock_new<Lock>(max_threads));
+        f(*lock);
+        return true;
+    };
+    return (visit_one(static_cast<Locks *>(nullptr)) || ...);
+}
+
+/**
+ * This function creates a reader-writer lock by name and calls f with a
+ * reference of the lock's concrete type, see user_lock_visit().
+ *
+ * Returns:
+ *	false if there is no lock with that name or the lock does not support
+ *	max_threads threads.
+ */
+template <typename F>
+bool user_rwlock_visit(const char *name, int max_threads, F &&f) {
+    return user_rwlock_visit(user_rwlock_types(), name, max_threads, f);
+}
+
+#endif // USER_RWLOCKS_HPP
@@ -0,0 +1,49 @@
+#ifndef WORK_QUEUE_LOCKED_HPP
+#define WORK_QUEUE_LOCKED_HPP
+
+#include "work_queues.hpp"
+
+inline work_queue_locked::work_queue_locked(size_t capacity)
+    : work_queue()
+    , m_items(new uint64_t[capacity])
+    , m_mask(capacity - 1)
+    , m_head(0)
+    , m_tail(0) {
+}
+
+// user_lock_mutex does not use the thread id, 0 is passed for all threads
+
+inline size_t work_queue_locked::try_enqueue_batch(const uint64_t *items,
+                                                   size_t n) {
+    m_lock.lock(0);
+    const size_t space = m_mask + 1 - (m_tail - m_head);
+    n = n < space ? n : space;
+    for (size_t i = 0; i < n; ++i) {
+        m_items[(m_tail + i) & m_mask] = items[i];
+    }
+    m_tail += n;
+    m_lock.unlock(0);
+    return n;
+}
+
+inline size_t work_queue_locked::try_dequeue_batch(uint64_t *items, size_t n) {
+    m_lock.lock(0);
+    const size_t available = m_tail - m_head;
+    n = n < available ? n : available;
+    for (size_t i = 0; i < n; ++i) {
+        items[i] = m_items[(m_head + i) & m_mask];
+    }
+    m_head += n;
+    m_lock.unlock(0);
+    return n;
+}
+
+inline bool work_queue_locked::try_enqueue(uint64_t item) {
+    return try_enqueue_batch(&item, 1) == 1;
+}
+
+inline bool work_queue_locked::try_dequeue(uint64_t &item) {
+    return try_dequeue_batch(&item, 1) == 1;
+}
+
+#endif // WORK_QUEUE_LOCKED_HPP
@@ -0,0 +1,34 @@
+#include "work_queues.hpp"
+
+template <typename Queue>
+static work_queue *create_queue(size_t capacity) {
+    return new Queue(capacity);
+}
+
+template <typename List>
+struct registry_of;
+
+template <typename... Queues>
+struct registry_of<work_queue_list<Queues...>> {
+    static constexpr work_queue_info entries[] = {
+        {Queues::name, create_queue<Queues>}...,
+        {nullptr, nullptr},
+    };
+};
+
+const work_queue_info *const work_queue_registry =
+    registry_of<work_queue_types>::entries;
+
+work_queue *work_queue_create(const char *name, size_t capacity) {
+    if (!work_queue_valid_capacity(capacity)) {
+        return nullptr;
+    }
+    for (const work_queue_info *info = work_queue_registry; info->name;
+         ++info) {
+        if (strcmp(info->name, name) == 0) {
+            return info->create(capacity);
+        }
+    }
+
+    return nullptr;
+}
@@ -0,0 +1,86 @@
+#ifndef WORK_QUEUE_VYUKOV_HPP
+#define WORK_QUEUE_VYUKOV_HPP
+
+#include "work_queues.hpp"
+
+inline work_queue_vyukov::work_queue_vyukov(size_t capacity)
+    : work_queue()
+    , m_slots(new slot[capacity])
+    , m_mask(capacity - 1)
+    , m_tail(0)
+    , m_head(0) {
+    for (size_t i = 0; i < capacity; ++i) {
+        m_slots[i].seq.store(i, std::memory_order_relaxed);
+    }
+}
+
+inline size_t work_queue_vyukov::claim(std::atomic<size_t> &pos, size_t offset,
+                                       size_t &n) {
+    size_t first = pos.load(std::memory_order_relaxed);
+    for (;;) {
+        // Count the consecutive slots that are ready for us. The acquire
+        // load makes the item (for a consumer), or the fact that the
+        // previous consumer is done with the slot (for a producer), visible.
+        size_t ready = 0;
+        bool stale = false;
+        while (ready < n) {
+            const size_t p = first + ready;
+            const size_t seq =
+                m_slots[p & m_mask].seq.load(std::memory_order_acquire);
+            const ptrdiff_t diff = ptrdiff_t(seq - (p + offset));
+            if (diff == 0) {
+                ready++;
+                continue;
+            }
+            // diff > 0: another thread has claimed the position since we
+            // read it. diff < 0: the queue is full (or empty) from here on.
+            stale = diff > 0 && ready == 0;
+            break;
+        }
+
+        if (stale) {
+            first = pos.load(std::memory_order_relaxed);
+        } else if (ready == 0) {
+            n = 0;
+            return first;
+        } else if (pos.compare_exchange_weak(first, first + ready,
+                                             std::memory_order_relaxed,
+                                             std::memory_order_relaxed)) {
+            n = ready;
+            return first;
+        }
+    }
+}
+
+inline size_t work_queue_vyukov::try_enqueue_batch(const uint64_t *items,
+                                                   size_t n) {
+    const size_t first = claim(m_tail, 0, n);
+    for (size_t i = 0; i < n; ++i) {
+        slot &s = m_slots[(first + i) & m_mask];
+        s.item = items[i];
+        // Hand the slot over to the consumer of this position
+        s.seq.store(first + i + 1, std::memory_order_release);
+    }
+    return n;
+}
+
+inline size_t work_queue_vyukov::try_dequeue_batch(uint64_t *items, size_t n) {
+    const size_t first = claim(m_head, 1, n);
+    for (size_t i = 0; i < n; ++i) {
+        slot &s = m_slots[(first + i) & m_mask];
+        items[i] = s.item;
+        // Hand the slot over to the producer of the position one lap ahead
+        s.seq.store(first + i + m_mask + 1, std::memory_order_release);
+    }
+    return n;
+}
+
+inline bool work_queue_vyukov::try_enqueue(uint64_t item) {
+    return try_enqueue_batch(&item, 1) == 1;
+}
+
+inline bool work_queue_vyukov::try_dequeue(uint64_t &item) {
+    return try_dequeue_batch(&item, 1) == 1;
+}
+
+#endif // WORK_QUEUE_VYUKOV_HPP
@@ -0,0 +1,216 @@
+#ifndef WORK_QUEUES_HPP
+#define WORK_QUEUES_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+#include "sync_common.hpp"
+#include "user_locks.hpp"
+
+/*******************************************************************************
+ *                              Base Queue Class                               *
+ ******************************************************************************/
+
+// Bounded multi-producer/multi-consumer FIFO queues. The items are 64-bit
+// values, e.g. indices into an array of tasks or pointers cast to uintptr_t.
+// Like the locks and counters, the queues derive from work_queue so that they
+// can be selected at runtime (see work_queue_create()), and are final and
+// implemented in headers so that code that knows the concrete type can
+// inline them (see work_queue_visit()).
+//
+// None of the operations block: they fail instead if the queue is full or
+// empty, and leave it to the caller to retry, back off or do something else.
+
+class work_queue {
+public:
+    /**
+     * Appends an item to the queue.
+     *
+     * Returns:
+     *	false if the queue is full.
+     */
+    virtual bool try_enqueue(uint64_t item) = 0;
+
+    /**
+     * Removes the item at the head of the queue and stores it in item.
+     *
+     * Returns:
+     *	false if the queue is empty.
+     */
+    virtual bool try_dequeue(uint64_t &item) = 0;
+
+    /**
+     * Appends up to n items, the first ones of items[]. The enqueued items
+     * are consecutive in the queue, items of other producers are never
+     * interleaved with them.
+     *
+     * Returns:
+     *	The number of enqueued items, 0 if the queue is full.
+     */
+    virtual size_t try_enqueue_batch(const uint64_t *items, size_t n) = 0;
+
+    /**
+     * Removes up to n consecutive items from the head of the queue and
+     * stores them in items[].
+     *
+     * Returns:
+     *	The number of dequeued items, 0 if the queue is empty.
+     */
+    virtual size_t try_dequeue_batch(uint64_t *items, size_t n) = 0;
+
+    virtual ~work_queue(){};
+};
+
+/*******************************************************************************
+ *                                Queue registry                               *
+ ******************************************************************************/
+
+struct work_queue_info {
+    // Name used to select the queue in the tests and benchmarks
+    const char *name;
+    // Creates a queue with room for capacity items, a power of two
+    work_queue *(*create)(size_t capacity);
+};
+
+// All available queues, terminated by an entry with name == nullptr
+extern const work_queue_info *const work_queue_registry;
+
+// Default capacity of the queues in the tests and benchmarks
+static const size_t work_queue_default_capacity = 1024;
+
+/**
+ * This function creates a queue by name. E.g.:
+ *
+ * std::unique_ptr<work_queue> queue(work_queue_create("vyukov", 1024));
+ *
+ * Arguments:
+ *	name: The name of the queue in work_queue_registry.
+ *	capacity: The maximum number of items in the queue, a power of two.
+ *
+ * Returns:
+ *	The new queue, or nullptr if there is no queue with that name or the
+ *	capacity is not a power of two.
+ */
+work_queue *work_queue_create(const char *name, size_t capacity);
+
+/*******************************************************************************
+ *                     Lock based queue (user_lock_mutex)                      *
+ ******************************************************************************/
+
+// Baseline: a ring buffer protected by a user_lock_mutex
+
+class work_queue_locked final : public work_queue {
+private:
+    user_lock_mutex m_lock;
+    std::unique_ptr<uint64_t[]> m_items;
+    size_t m_mask;
+    // Positions of the next item to dequeue and to enqueue, only accessed
+    // with m_lock held. They grow forever, the slot is position & m_mask.
+    size_t m_head;
+    size_t m_tail;
+
+public:
+    static constexpr const char *name = "locked";
+
+    explicit work_queue_locked(size_t capacity = work_queue_default_capacity);
+
+    bool try_enqueue(uint64_t item) override;
+    bool try_dequeue(uint64_t &item) override;
+    size_t try_enqueue_batch(const uint64_t *items, size_t n) override;
+    size_t try_dequeue_batch(uint64_t *items, size_t n) override;
+};
+
+/*******************************************************************************
+ *                Bounded MPMC queue with per-slot sequence numbers            *
+ ******************************************************************************/
+
+// Dmitry Vyukov's bounded MPMC queue. Every slot has a sequence number that
+// says whose turn it is: seq == pos means the slot is free for the producer
+// that claims position pos, seq == pos + 1 means it holds the item for the
+// consumer that claims position pos. Producers and consumers claim positions
+// with a CAS on m_tail and m_head respectively and then only touch their own
+// slot, so a producer never waits for another producer (or a consumer for
+// another consumer) to finish.
+
+class work_queue_vyukov final : public work_queue {
+private:
+    struct alignas(CACHE_LINE_SIZE) slot {
+        std::atomic<size_t> seq;
+        uint64_t item;
+    };
+
+    std::unique_ptr<slot[]> m_slots;
+    size_t m_mask;
+
+    // The next position to enqueue at and to dequeue from, written by the
+    // producers and the consumers respectively, in separate cache lines.
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_tail;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_head;
+
+    // Claims up to n positions starting at m_tail (or m_head), whose slots
+    // have the sequence number position + offset. Returns the first position,
+    // and the number of claimed positions in n.
+    size_t claim(std::atomic<size_t> &pos, size_t offset, size_t &n);
+
+public:
+    static constexpr const char *name = "vyukov";
+
+    explicit work_queue_vyukov(size_t capacity = work_queue_default_capacity);
+
+    bool try_enqueue(uint64_t item) override;
+    bool try_dequeue(uint64_t &item) override;
+    size_t try_enqueue_batch(const uint64_t *items, size_t n) override;
+    size_t try_dequeue_batch(uint64_t *items, size_t n) override;
+};
+
+/*******************************************************************************
+ *                         Implementations and dispatch                        *
+ ******************************************************************************/
+
+#include "work_queue_locked.hpp"
+#include "work_queue_vyukov.hpp"
+
+template <typename... Queues>
+struct work_queue_list {};
+
+// All queues, in the order in which they are listed in work_queue_registry
+using work_queue_types = work_queue_list<work_queue_locked, work_queue_vyukov>;
+
+inline bool work_queue_valid_capacity(size_t capacity) {
+    return capacity && (capacity & (capacity - 1)) == 0;
+}
+
+template <typename F, typename... Queues>
+bool work_queue_visit(work_queue_list<Queues...>, const char *name,
+                      size_t capacity, F &f) {
+    auto visit_one = [&](auto *type_tag) {
+        using Queue = std::remove_pointer_t<decltype(type_tag)>;
+        if (strcmp(name, Queue::name) != 0) {
+            return false;
+        }
+        std::unique_ptr<Queue> queue(new Queue(capacity));
+        f(*queue);
+        return true;
+    };
+    return work_queue_valid_capacity(capacity) &&
+           (visit_one(static_cast<Queues *>(nullptr)) || ...);
+}
+
+/**
+ * This function creates a queue by name, like work_queue_create(), and calls
+ * f with a reference of the queue's concrete type, see user_lock_visit().
+ *
+ * Returns:
+ *	false if there is no queue with that name or the capacity is not a
+ *	power of two.
+ */
+template <typename F>
+bool work_queue_visit(const char *name, size_t capacity, F &&f) {
+    return work_queue_visit(work_queue_types(), name, capacity, f);
+}
+
+#endif // WORK_QUEUES_HPP
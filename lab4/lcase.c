@@ -272,7 +272,9 @@ run_tests(const char *restrict in, size_t len,
 
         printf("Starting SSE run...\n");
         util_monotonic_time(&ts_start);
+        util_roi_begin();
         f_test(test_area, in, len);
+        util_roi_end();
         util_monotonic_time(&ts_stop);
         runtime_sse = util_time_diff(&ts_start, &ts_stop);
         printf("SSE run completed in %.2f s (%.1f MB/s)\n",
@@ -539,7 +539,9 @@ run_multiply()
         printf("Starting optimized run...\n");
         util_monotonic_time(&ts_start);
         /* mat_c = mat_a * mat_b */
+        util_roi_begin();
         matmul_sse();
+        util_roi_end();
         util_monotonic_time(&ts_stop);
         runtime_sse = util_time_diff(&ts_start, &ts_stop);
         printf("Optimized run completed in %.2f s\n",
@@ -72,6 +72,19 @@ print_vector_epi8(__m128i v)
 }
 
 
+void __attribute__((noinline))
+util_roi_begin(void)
+{
+        /* Keep the compiler from optimizing the call away */
+        __asm__ __volatile__("" ::: "memory");
+}
+
+void __attribute__((noinline))
+util_roi_end(void)
+{
+        __asm__ __volatile__("" ::: "memory");
+}
+
 void
 print_vector_pd(__m128d v)
 {
@@ -38,6 +38,17 @@ void util_monotonic_time(struct timespec *ts);
  */
 double util_time_diff(struct timespec *ts_start, struct timespec *ts_stop);
 
+/**
+ * Region of interest markers. These functions don't do anything, but
+ * the AvDark cache simulator (pin-avdc.sh -roi 1) recognizes calls
+ * to them and only simulates the code executed in between.
+ *
+ * @{
+ */
+void util_roi_begin(void);
+void util_roi_end(void);
+/** @} */
+
 /**
  * Print the contents of a vector of characters.
  *